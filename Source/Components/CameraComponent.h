@@ -148,12 +148,14 @@ namespace GiiGa
         CameraComponent(CameraType type = Perspective, float FOV = 90, float aspect = 16 / 9, float width = 1280, float height = 720, float Near = 0.01, float Far = 100)
         {
             camera_ = Camera{type, FOV, aspect, width, height, Near, Far};
+            tick_type = TickType::PreRender;
         };
 
         CameraComponent(Json::Value json, bool roll_id = false):
             Component(json, roll_id)
         {
             camera_ = Camera(json["Camera"]);
+            tick_type = TickType::PreRender;
         }
 
         ::Json::Value DerivedToJson(bool is_prefab_root) override
@@ -180,6 +182,11 @@ namespace GiiGa
 
         Camera GetCamera() const { return camera_; }
 
+        InitPriority GetInitPriority() const override
+        {
+            return InitPriority::Camera;
+        }
+
         void Init() override
         {
             ownerGO_ = std::dynamic_pointer_cast<GameObject>(owner_.lock());
@@ -219,6 +226,12 @@ namespace GiiGa
             Todo();
         }
 
+        // world getters of transform resolve lazily, so it is declared written
+        TickAccess GetTickAccess() const override
+        {
+            return TickAccess::Workers().Writes<TransformComponent>();
+        }
+
         void Tick(float dt) override
         {
             if (ownerGO_.expired() || ownerGO_.lock()->GetTransformComponent().expired()) return;
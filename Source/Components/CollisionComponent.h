@@ -56,7 +56,6 @@ namespace GiiGa
         {
             Engine::Instance().RenderSystem()->UnregisterInUpdateGPUData(this);
             PhysicsSystem::UnRegisterCollision(this);
-            OnUpdateTransform.Unregister(cashed_event_);
         }
 
         void ConstructFunction()
@@ -78,7 +77,7 @@ namespace GiiGa
 
         void ChooseMeshAsset()
         {
-            if (mesh_)
+            if (mesh_ && visibilityEntry_)
             {
                 visibilityEntry_->Unregister();
             }
@@ -96,7 +95,13 @@ namespace GiiGa
                 break;
             }
             mesh_ = rm->GetAsset<MeshAsset<VertexPNTBT>>(mesh_asset);
-            visibilityEntry_ = VisibilityEntry::Register(std::dynamic_pointer_cast<CollisionComponent>(shared_from_this()), mesh_->GetAABB());
+            if (IsOwnerActive())
+                RegisterInVisibility();
+        }
+
+        InitPriority GetInitPriority() const override
+        {
+            return InitPriority::NearCamera;
         }
 
         void Init() override
@@ -106,8 +111,6 @@ namespace GiiGa
             if (!mesh_)
             {
                 ChooseMeshAsset();
-
-                RegisterInVisibility();
             }
         }
 
@@ -125,7 +128,31 @@ namespace GiiGa
         {
             TransformComponent::BeginPlay();
 
-            RegisterInPhysics();
+            is_playing_ = true;
+            if (IsOwnerActive())
+                RegisterInPhysics();
+        }
+
+        // PhysicsSystem::EndPlay drops every body
+        void EndPlay() override
+        {
+            TransformComponent::EndPlay();
+            is_playing_ = false;
+        }
+
+        void OnPoolRelease() override
+        {
+            PhysicsSystem::UnRegisterCollision(this);
+            body_id_ = JPH::BodyID();
+            visibilityEntry_.reset();
+        }
+
+        void OnPoolAcquire() override
+        {
+            if (mesh_ && !visibilityEntry_)
+                RegisterInVisibility();
+            if (is_playing_ && body_id_.IsInvalid())
+                RegisterInPhysics();
         }
 
         void Tick(float dt) override
@@ -249,25 +276,13 @@ namespace GiiGa
         std::unique_ptr<VisibilityEntry> visibilityEntry_;
         std::shared_ptr<PerObjectData> perObjectData_;
         std::shared_ptr<MeshAsset<VertexPNTBT>> mesh_;
-        EventHandle<std::shared_ptr<TransformComponent>> cashed_event_ = EventHandle<std::shared_ptr<TransformComponent>>::Null();
-
         JPH::BodyID body_id_;
+        bool is_playing_ = false;
 
         void RegisterInVisibility()
         {
-            if (cashed_event_.isValid())
-            {
-                OnUpdateTransform.Unregister(cashed_event_);
-            }
-            cashed_event_ = OnUpdateTransform.Register(
-                [this](const std::shared_ptr<TransformComponent>& e)
-                {
-                    DirectX::BoundingBox origaabb = mesh_->GetAABB();
-
-                    origaabb.Transform(origaabb, GetWorldMatrix());
-
-                    visibilityEntry_->Update(origaabb);
-                });
+            visibilityEntry_ = VisibilityEntry::Register(std::dynamic_pointer_cast<CollisionComponent>(shared_from_this()), mesh_->GetAABB());
+            visibilityEntry_->BindTransform(GetTransformId(), mesh_->GetAABB());
         }
 
         void RegisterInPhysics()
@@ -15,6 +15,12 @@ namespace GiiGa
         ConsoleComponent(Json::Value json, bool roll_id = false):
             Component(json, roll_id)
         {
+            tick_type = TickType::PrePhysics;
+        }
+
+        TickAccess GetTickAccess() const override
+        {
+            return TickAccess::MainThread();
         }
 
         void Tick(float dt) override
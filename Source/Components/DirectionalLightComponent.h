@@ -157,6 +157,23 @@ namespace GiiGa
         {
         }
 
+        void OnPoolRelease() override
+        {
+            visibilityEntry_.reset();
+        }
+
+        void OnPoolAcquire() override
+        {
+            if (mesh_ && !visibilityEntry_)
+                RegisterInVisibility();
+        }
+
+        // lights whole view, goes with camera
+        InitPriority GetInitPriority() const override
+        {
+            return InitPriority::Camera;
+        }
+
         void Init() override
         {
             transform_ = std::dynamic_pointer_cast<GameObject>(owner_.lock())->GetTransformComponent();
@@ -166,7 +183,8 @@ namespace GiiGa
 
                 mesh_ = rm->GetAsset<MeshAsset<VertexPNTBT>>(DefaultAssetsHandles::Quad);
 
-                RegisterInVisibility();
+                if (IsOwnerActive())
+                    RegisterInVisibility();
             }
 
             auto& device = Engine::Instance().RenderSystem()->GetRenderDevice();
@@ -182,6 +200,12 @@ namespace GiiGa
             mesh_->Draw(context.GetGraphicsCommandList());
         }
 
+        // registered lights are the ones passes draw, pooled and not yet initialized ones are not
+        bool IsInVisibility() const
+        {
+            return visibilityEntry_ != nullptr;
+        }
+
         SortData GetSortData() override
         {
             return {
@@ -468,7 +492,8 @@ namespace GiiGa
                     origaabb.Transform(origaabb, trans.GetMatrix());
                     isDirty = true;
 
-                    visibilityEntry_->Update(origaabb);
+                    if (visibilityEntry_)
+                        visibilityEntry_->Update(origaabb);
                 });
         }
     };
@@ -128,6 +128,22 @@ namespace GiiGa
         {
         }
 
+        void OnPoolRelease() override
+        {
+            visibilityEntry_.reset();
+        }
+
+        void OnPoolAcquire() override
+        {
+            if (mesh_ && !visibilityEntry_)
+                RegisterInVisibility();
+        }
+
+        InitPriority GetInitPriority() const override
+        {
+            return InitPriority::NearCamera;
+        }
+
         void Init() override
         {
             transform_ = std::dynamic_pointer_cast<GameObject>(owner_.lock())->GetTransformComponent();
@@ -137,7 +153,8 @@ namespace GiiGa
 
                 mesh_ = rm->GetAsset<MeshAsset<VertexPNTBT>>(DefaultAssetsHandles::Sphere);
 
-                RegisterInVisibility();
+                if (IsOwnerActive())
+                    RegisterInVisibility();
             }
         }
 
@@ -292,7 +309,8 @@ namespace GiiGa
                     data_.radius = std::max(trans.scale_.x, std::max(trans.scale_.y, trans.scale_.z));
                     isDirty = true;
 
-                    visibilityEntry_->Update(origaabb);
+                    if (visibilityEntry_)
+                        visibilityEntry_->Update(origaabb);
                 });
         }
     };
@@ -100,7 +100,7 @@ namespace GiiGa
             else
             {
                 substituter_component_->SetProperties(prop_modifications.prop_modifications);
-                this->Destroy();
+                this->DestroyImmediate();
             }
         }
 
@@ -19,7 +19,17 @@ namespace GiiGa
         friend class ScriptAsset;
 
     public:
-        using Component::Component;
+        // python behaviours always tick, their Tick can not be inspected from here
+        PyBehaviourTrampoline()
+        {
+            tick_type = TickType::PrePhysics;
+        }
+
+        PyBehaviourTrampoline(const Json::Value& json, bool roll_id = false):
+            Component(json, roll_id)
+        {
+            tick_type = TickType::PrePhysics;
+        }
 
         void Init() override
         {
@@ -127,6 +137,38 @@ namespace GiiGa
             }
         }
 
+        void OnPoolRelease() override
+        {
+            try
+            {
+                PYBIND11_OVERRIDE(
+                    void,
+                    GiiGa::Component,
+                    OnPoolRelease
+                );
+            }
+            catch (pybind11::error_already_set& e)
+            {
+                el::Loggers::getLogger(LogPyScript)->debug("PyBehaviourTrampoline::OnPoolRelease %v", e.what());
+            }
+        }
+
+        void OnPoolAcquire() override
+        {
+            try
+            {
+                PYBIND11_OVERRIDE(
+                    void,
+                    GiiGa::Component,
+                    OnPoolAcquire
+                );
+            }
+            catch (pybind11::error_already_set& e)
+            {
+                el::Loggers::getLogger(LogPyScript)->debug("PyBehaviourTrampoline::OnPoolAcquire %v", e.what());
+            }
+        }
+
         std::shared_ptr<IComponent> Clone(std::unordered_map<Uuid, Uuid>& original_uuid_to_world_uuid, const std::optional<std::unordered_map<Uuid, Uuid>>& instance_uuid) override
         {
             Todo();
@@ -22,6 +22,11 @@ namespace GiiGa
     class SpectatorMovementComponent : public Component
     {
     public:
+        SpectatorMovementComponent()
+        {
+            tick_type = TickType::PrePhysics;
+        }
+
         void Init() override
         {
             const auto GO = std::dynamic_pointer_cast<GameObject>(owner_.lock());
@@ -70,6 +75,11 @@ namespace GiiGa
             return Json::Value();
         };
 
+        TickAccess GetTickAccess() const override
+        {
+            return TickAccess::Workers().Writes<TransformComponent>();
+        }
+
         void Tick(float dt) override
         {
             if (!active_) return;
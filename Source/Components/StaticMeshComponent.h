@@ -3,6 +3,8 @@
 #include <DirectXCollision.h>
 #include <unordered_map>
 #include <vector>
+#include <span>
+#include <algorithm>
 
 #include<memory>
 #include<json/value.h>
@@ -25,6 +27,13 @@
 
 namespace GiiGa
 {
+    struct StaticMeshLod
+    {
+        std::shared_ptr<MeshAsset<VertexPNTBT>> mesh;
+        // view distance this LOD starts at
+        float distance;
+    };
+
     class StaticMeshComponent : public Component, public IRenderable, public IUpdateGPUData
     {
         //todo: temp
@@ -49,6 +58,19 @@ namespace GiiGa
                     material_ = Engine::Instance().ResourceManager()->GetAsset<Material>(material_handle);
                 }
             }
+
+            for (const auto& lod_json : json["Lods"])
+            {
+                auto lod_handle = AssetHandle::FromJson(lod_json["Mesh"]);
+                if (lod_handle != AssetHandle{})
+                    lods_.push_back({Engine::Instance().ResourceManager()->GetAsset<MeshAsset<VertexPNTBT>>(lod_handle), lod_json["Distance"].asFloat()});
+            }
+            UpdateLodDistances();
+
+            isOccluder_ = json["IsOccluder"].asBool();
+            occluderBox_.Center = Vector3FromJson(json["OccluderBox"]["Center"]);
+            occluderBox_.Extents = Vector3FromJson(json["OccluderBox"]["Extents"]);
+            isStatic_ = json["IsStatic"].asBool();
         }
 
         Json::Value DerivedToJson(bool is_prefab_root) override
@@ -57,6 +79,18 @@ namespace GiiGa
             result["Type"] = typeid(StaticMeshComponent).name();
             result["Mesh"] = mesh_ ? mesh_->GetId().ToJson() : AssetHandle{}.ToJson();
             result["Material"] = material_ ? material_->GetId().ToJson() : AssetHandle{}.ToJson();
+            result["Lods"] = Json::arrayValue;
+            for (const auto& lod : lods_)
+            {
+                Json::Value lod_json;
+                lod_json["Mesh"] = lod.mesh->GetId().ToJson();
+                lod_json["Distance"] = lod.distance;
+                result["Lods"].append(lod_json);
+            }
+            result["IsOccluder"] = isOccluder_;
+            result["OccluderBox"]["Center"] = Vector3ToJson(occluderBox_.Center);
+            result["OccluderBox"]["Extents"] = Vector3ToJson(occluderBox_.Extents);
+            result["IsStatic"] = isStatic_;
             return result;
         }
 
@@ -64,17 +98,29 @@ namespace GiiGa
         {
             if (perObjectData_)
                 Engine::Instance().RenderSystem()->UnregisterInUpdateGPUData(this);
-            if (auto l_owner = owner_.lock())
-            {
-                if (auto l_trans = std::dynamic_pointer_cast<GameObject>(l_owner)->GetTransformComponent().lock())
-                    l_trans->OnUpdateTransform.Unregister(cashed_event_);
-            }
         }
 
         void Tick(float dt) override
         {
         }
 
+        void OnPoolRelease() override
+        {
+            visibilityEntry_.reset();
+        }
+
+        // before Init there is nothing to restore, Init registers on its own
+        void OnPoolAcquire() override
+        {
+            if (perObjectData_ && mesh_ && should_register_ && !visibilityEntry_)
+                RegisterInVisibility();
+        }
+
+        InitPriority GetInitPriority() const override
+        {
+            return InitPriority::NearCamera;
+        }
+
         void Init() override
         {
             transform_ = std::dynamic_pointer_cast<GameObject>(owner_.lock())->GetTransformComponent();
@@ -86,7 +132,7 @@ namespace GiiGa
 
                     material_ = rm->GetAsset<Material>(DefaultAssetsHandles::DefaultMaterial);
                 }
-                if (!visibilityEntry_ && should_register_)
+                if (!visibilityEntry_ && should_register_ && IsOwnerActive())
                     RegisterInVisibility();
             }
 
@@ -104,10 +150,15 @@ namespace GiiGa
         std::shared_ptr<IComponent> Clone(std::unordered_map<Uuid, Uuid>& original_uuid_to_world_uuid,
                                           const std::optional<std::unordered_map<Uuid, Uuid>>& instance_uuid) override
         {
-            auto clone = std::make_shared<StaticMeshComponent>();
+            auto clone = MakeComponent<StaticMeshComponent>();
             this->CloneBase(clone, original_uuid_to_world_uuid, instance_uuid);
             clone->mesh_ = mesh_;
             clone->material_ = material_;
+            clone->lods_ = lods_;
+            clone->lod_distances_ = lod_distances_;
+            clone->isOccluder_ = isOccluder_;
+            clone->occluderBox_ = occluderBox_;
+            clone->isStatic_ = isStatic_;
             return clone;
         }
 
@@ -154,6 +205,32 @@ namespace GiiGa
             mesh_->Draw(context.GetGraphicsCommandList());
         }
 
+        void DrawLod(RenderContext& context, uint8_t lod) override
+        {
+            if (lod == 0 || lod > lods_.size())
+                mesh_->Draw(context.GetGraphicsCommandList());
+            else
+                lods_[lod - 1].mesh->Draw(context.GetGraphicsCommandList());
+        }
+
+        std::span<const float> GetLodDistances() override
+        {
+            return lod_distances_;
+        }
+
+        // LODs after the main mesh, culling bounds stay the main mesh's AABB.
+        void SetLods(std::vector<StaticMeshLod> lods)
+        {
+            std::erase_if(lods, [](const StaticMeshLod& lod) { return !lod.mesh; });
+            lods_ = std::move(lods);
+            UpdateLodDistances();
+        }
+
+        const std::vector<StaticMeshLod>& GetLods() const
+        {
+            return lods_;
+        }
+
         SortData GetSortData() override
         {
             return {.object_mask = mesh_->GetObjectMask() | material_->GetMaterialMask(), .shaderResource = material_->GetShaderResource()};
@@ -197,7 +274,7 @@ namespace GiiGa
             else
             {
                 mesh_ = Engine::Instance().ResourceManager()->GetAsset<MeshAsset<VertexPNTBT>>(new_handle);
-                if (perObjectData_)
+                if (perObjectData_ && IsOwnerActive())
                     RegisterInVisibility();
 
                 if (!material_)
@@ -230,6 +307,50 @@ namespace GiiGa
             material_ = mat;
         }
 
+        bool IsStatic() const
+        {
+            return isStatic_;
+        }
+
+        // Static meshes are culled through static bvh, which is rebuilt when they are added or removed
+        // and refit when they move, so mark only meshes that rarely move.
+        void SetIsStatic(bool is_static)
+        {
+            if (isStatic_ == is_static)
+                return;
+
+            isStatic_ = is_static;
+            if (visibilityEntry_)
+                visibilityEntry_->SetStatic(isStatic_);
+            if (perObjectData_)
+                perObjectData_ = std::make_shared<PerObjectData>(Engine::Instance().RenderSystem()->GetRenderContext(), transform_.lock(), isStatic_);
+        }
+
+        bool IsOccluder() const
+        {
+            return isOccluder_;
+        }
+
+        // Occluders rasterize their occluder box into CPU occlusion buffer and can hide other meshes.
+        void SetIsOccluder(bool is_occluder)
+        {
+            isOccluder_ = is_occluder;
+            UpdateOccluder();
+        }
+
+        const DirectX::BoundingBox& GetOccluderBox() const
+        {
+            return occluderBox_;
+        }
+
+        // Box in mesh space that has to lie inside the solid part of the mesh, e.g. wall core without openings.
+        // Mesh AABB is not used, it would hide objects seen past rotated, concave or open meshes.
+        void SetOccluderBox(const DirectX::BoundingBox& box)
+        {
+            occluderBox_ = box;
+            UpdateOccluder();
+        }
+
         void UpdateGPUData(RenderContext& context) override
         {
             perObjectData_->UpdateGPUData(context);
@@ -244,33 +365,38 @@ namespace GiiGa
         std::shared_ptr<MeshAsset<VertexPNTBT>> mesh_;
         std::shared_ptr<Material> material_;
         std::unique_ptr<VisibilityEntry> visibilityEntry_;
-        EventHandle<std::shared_ptr<TransformComponent>> cashed_event_ = EventHandle<std::shared_ptr<TransformComponent>>::Null();
         std::weak_ptr<TransformComponent> transform_;
         std::shared_ptr<PerObjectData> perObjectData_;
         bool should_register_ = true;
-        //TODO
-        //Добавить возможность делать статик меши статическими или динамическими
         bool isStatic_ = false;
+        bool isOccluder_ = false;
+        DirectX::BoundingBox occluderBox_{{}, {}};
+        std::vector<StaticMeshLod> lods_;
+        std::vector<float> lod_distances_;
 
-        void RegisterInVisibility()
+        void UpdateLodDistances()
         {
-            visibilityEntry_.reset();
-            visibilityEntry_ = VisibilityEntry::Register(std::dynamic_pointer_cast<IRenderable>(shared_from_this()), mesh_->GetAABB());
-            if (cashed_event_.isValid())
-            {
-                std::dynamic_pointer_cast<GameObject>(owner_.lock())->GetTransformComponent().lock()->OnUpdateTransform.Unregister(cashed_event_);
-            }
-            cashed_event_ = std::dynamic_pointer_cast<GameObject>(owner_.lock())->GetTransformComponent().lock()->OnUpdateTransform.Register(
-                [this](const std::shared_ptr<TransformComponent>& e)
-                {
-                    auto owner_go = std::dynamic_pointer_cast<GameObject>(owner_.lock());
-                    Transform trans = owner_go->GetComponent<TransformComponent>()->GetWorldTransform();
-                    DirectX::BoundingBox origaabb = mesh_->GetAABB();
+            std::sort(lods_.begin(), lods_.end(), [](const StaticMeshLod& lhs, const StaticMeshLod& rhs) { return lhs.distance < rhs.distance; });
+            lod_distances_.clear();
+            for (const auto& lod : lods_)
+                lod_distances_.push_back(lod.distance);
+        }
 
-                    origaabb.Transform(origaabb, trans.GetMatrix());
+        void UpdateOccluder()
+        {
+            if (!visibilityEntry_) return;
+            if (isOccluder_)
+                visibilityEntry_->SetOccluder(occluderBox_);
+            else
+                visibilityEntry_->SetOccluder(std::nullopt);
+        }
 
-                    visibilityEntry_->Update(origaabb);
-                });
+        void RegisterInVisibility()
+        {
+            visibilityEntry_.reset();
+            visibilityEntry_ = VisibilityEntry::Register(std::dynamic_pointer_cast<IRenderable>(shared_from_this()), mesh_->GetAABB(), isStatic_);
+            UpdateOccluder();
+            visibilityEntry_->BindTransform(std::dynamic_pointer_cast<GameObject>(owner_.lock())->GetTransformComponent().lock()->GetTransformId(), mesh_->GetAABB());
         }
     };
 }
@@ -5,13 +5,16 @@
 #include<directxtk12/SimpleMath.h>
 #include<memory>
 #include<optional>
+#include<span>
 
 #include<DXMathUtils.h>
 #include<Component.h>
+#include<ComponentAllocator.h>
 #include<EventSystem.h>
 #include<IWorldQuery.h>
 #include<Logger.h>
 #include<PrefabInstanceModifications.h>
+#include<TransformSystem.h>
 
 namespace GiiGa
 {
@@ -152,6 +155,7 @@ namespace GiiGa
 
 #pragma region TransformComopnent
     // todo: add to json
+    // thin handle into TransformSystem storage, matrices are propagated at TransformSystem::Update
     class TransformComponent : public Component
     {
     public:
@@ -159,29 +163,44 @@ namespace GiiGa
                            , const Vector3 rotation = Vector3::Zero
                            , const Vector3 scale = Vector3::One
                            , const std::shared_ptr<TransformComponent>& parent = nullptr)
+            : TransformComponent(Transform{location, rotation, scale}, parent)
         {
-            transform_ = Transform{location, rotation, scale};
-            if (parent) AttachTo(parent);
         }
 
         TransformComponent(const Transform& transform, const std::shared_ptr<TransformComponent>& parent = nullptr)
         {
-            transform_ = transform;
+            id_ = TransformSystem::GetInstance().Create(this, transform.location_, transform.rotate_, transform.scale_);
             if (parent) AttachTo(parent);
         }
 
         TransformComponent(const Json::Value& json, bool roll_id = false):
             Component(json, roll_id)
         {
-            transform_ = Transform(json["Transform"]);
+            const Transform transform = Transform(json["Transform"]);
+            id_ = TransformSystem::GetInstance().Create(this, transform.location_, transform.rotate_, transform.scale_);
+        }
+
+        TransformComponent(const TransformComponent&) = delete;
+
+        ~TransformComponent() override
+        {
+            TransformSystem::GetInstance().Destroy(id_);
         }
 
         TransformComponent* operator=(const std::weak_ptr<TransformComponent>& other)
         {
             if (this == other.lock().get()) return this;
-            std::weak_ptr temp(other);
-            std::swap(this->transform_, temp.lock()->transform_);
-            std::swap(this->parent_, temp.lock()->parent_);
+            auto l_other = other.lock();
+
+            const Transform temp = GetTransform();
+            WriteTransform(l_other->GetTransform());
+            l_other->WriteTransform(temp);
+
+            auto other_parent = l_other->parent_;
+            l_other->Detach();
+            l_other->AttachTo(parent_);
+            Detach();
+            AttachTo(other_parent);
             return this;
         }
 
@@ -191,8 +210,8 @@ namespace GiiGa
 
             auto prefab_trans = std::static_pointer_cast<TransformComponent>(prefab_comp);
 
-            if (this->transform_ != prefab_trans->transform_)
-                result.push_back({{this->inprefab_uuid_, "Transform"}, this->transform_.ToJson()});
+            if (this->GetTransform() != prefab_trans->GetTransform())
+                result.push_back({{this->inprefab_uuid_, "Transform"}, this->GetTransform().ToJson()});
 
             if (!this->parent_.expired() && !prefab_trans->parent_.expired())
             {
@@ -213,7 +232,7 @@ namespace GiiGa
         void ApplyModifications(const PrefabPropertyModifications& modifications) override
         {
             if (modifications.contains({this->inprefab_uuid_, "Transform"}))
-                this->transform_ = Transform{modifications.at({this->inprefab_uuid_, "Transform"})};
+                WriteTransform(Transform{modifications.at({this->inprefab_uuid_, "Transform"})});
 
             if (modifications.contains({this->inprefab_uuid_, "Parent"}))
             {
@@ -232,7 +251,7 @@ namespace GiiGa
 
         bool operator==(const TransformComponent* rhs) const
         {
-            return transform_ == rhs->transform_;
+            return GetTransform() == rhs->GetTransform();
         }
 
         Json::Value DerivedToJson(bool is_prefab_root = false) override
@@ -242,7 +261,7 @@ namespace GiiGa
             result["Type"] = typeid(TransformComponent).name();
 
             if (!is_prefab_root)
-                result["Transform"] = transform_.ToJson();
+                result["Transform"] = GetTransform().ToJson();
             else
                 result["Transform"] = Transform{}.ToJson();
 
@@ -257,9 +276,8 @@ namespace GiiGa
         std::shared_ptr<IComponent> Clone(std::unordered_map<Uuid, Uuid>& original_uuid_to_world_uuid,
                                           const std::optional<std::unordered_map<Uuid, Uuid>>& instance_uuid) override
         {
-            auto clone = std::make_shared<TransformComponent>();
+            auto clone = MakeComponent<TransformComponent>(GetTransform());
             this->CloneBase(clone, original_uuid_to_world_uuid, instance_uuid);
-            clone->transform_ = transform_;
             return clone;
         }
 
@@ -299,7 +317,11 @@ namespace GiiGa
 
         void Tick(float dt) override
         {
-            if (is_dirty_) UpdateTransformMatrices();
+        }
+
+        InitPriority GetInitPriority() const override
+        {
+            return InitPriority::Transform;
         }
 
         void Init() override
@@ -311,20 +333,22 @@ namespace GiiGa
         {
         }
 
-        Transform GetTransform() const { return transform_; }
+        Transform GetTransform() const
+        {
+            const auto& system = TransformSystem::GetInstance();
+            return Transform{system.GetLocation(id_), system.GetRotation(id_), system.GetScale(id_)};
+        }
 
         virtual void SetTransform(const Transform& transform)
         {
-            transform_ = transform;
-            UpdateTransformMatrices();
+            WriteTransform(transform);
         }
 
-        Vector3 GetLocation() const { return transform_.location_; }
+        Vector3 GetLocation() const { return TransformSystem::GetInstance().GetLocation(id_); }
 
         virtual void SetLocation(const Vector3& location)
         {
-            transform_.location_ = location;
-            UpdateTransformMatrices();
+            TransformSystem::GetInstance().SetLocation(id_, location);
         }
 
         virtual void AddLocation(const Vector3& location)
@@ -333,18 +357,16 @@ namespace GiiGa
             SetLocation(new_location);
         }
 
-        Vector3 GetRotation() const { return transform_.GetRotation(); }
+        Vector3 GetRotation() const { return GetTransform().GetRotation(); }
 
         virtual void SetRotation(const Vector3& rotation)
         {
-            transform_.SetRotation(rotation);
-            UpdateTransformMatrices();
+            TransformSystem::GetInstance().SetRotation(id_, Transform::QuatFromRot(rotation));
         }
 
         virtual void SetRotation(const Quaternion& rotation)
         {
-            transform_.rotate_ = rotation;
-            UpdateTransformMatrices();
+            TransformSystem::GetInstance().SetRotation(id_, rotation);
         }
 
         virtual void AddRotation(const Vector3& rotation)
@@ -356,17 +378,16 @@ namespace GiiGa
         void AddQuatRotation(const Vector3& rotation)
         {
             auto q_new = Transform::QuatFromRot(rotation);
-            auto rot = q_new * transform_.rotate_;
+            auto rot = q_new * TransformSystem::GetInstance().GetRotation(id_);
             rot.Normalize();
             SetRotation(rot);
         }
 
-        Vector3 GetScale() const { return transform_.scale_; }
+        Vector3 GetScale() const { return TransformSystem::GetInstance().GetScale(id_); }
 
         virtual void SetScale(const Vector3& scale)
         {
-            transform_.scale_ = scale;
-            UpdateTransformMatrices();
+            TransformSystem::GetInstance().SetScale(id_, scale);
         }
 
         virtual void AddScale(const Vector3& scale)
@@ -375,26 +396,34 @@ namespace GiiGa
             SetScale(new_scale);
         }
 
-        Transform GetWorldTransform() const { return Transform::TransformFromMatrix(world_matrix_); }
+        Transform GetWorldTransform() const
+        {
+            auto& system = TransformSystem::GetInstance();
+            return Transform{system.GetWorldLocation(id_), system.GetWorldRotation(id_), system.GetWorldScale(id_)};
+        }
 
         virtual void SetWorldTransform(const Transform& transform)
         {
-            const auto pref_world_matrix = world_matrix_;
-            world_matrix_ = transform.GetMatrix();
-            Matrix world_to_local = pref_world_matrix.Invert() * local_matrix_;
-            local_matrix_ = world_matrix_ * world_to_local;
-            transform_ = Transform::TransformFromMatrix(local_matrix_);
-            OnUpdateTransform.Invoke(std::dynamic_pointer_cast<TransformComponent>(shared_from_this()));
+            if (parent_.expired())
+            {
+                WriteTransform(transform);
+                return;
+            }
+
+            auto& system = TransformSystem::GetInstance();
+            Matrix world_to_local = system.GetWorldMatrix(id_).Invert() * system.GetLocalMatrix(id_);
+            const Matrix local_matrix = transform.GetMatrix() * world_to_local;
+            WriteTransform(Transform::TransformFromMatrix(local_matrix));
         }
 
         Vector3 GetWorldLocation() const
         {
-            return Transform::TransformFromMatrix(world_matrix_).location_;
+            return TransformSystem::GetInstance().GetWorldLocation(id_);
         }
 
         virtual void SetWorldLocation(const Vector3& location)
         {
-            Transform world_trans = Transform::TransformFromMatrix(world_matrix_);
+            Transform world_trans = GetWorldTransform();
             world_trans.location_ = location;
             SetWorldTransform(world_trans);
         }
@@ -407,43 +436,42 @@ namespace GiiGa
 
         Vector3 GetWorldRotation() const
         {
-            return Transform::TransformFromMatrix(world_matrix_).GetRotation();
+            return DegFromRad(GetWorldQuatRotation().ToEuler());
         }
 
         Quaternion GetWorldQuatRotation() const
         {
-            return Transform::TransformFromMatrix(world_matrix_).rotate_;
+            return TransformSystem::GetInstance().GetWorldRotation(id_);
         }
 
         virtual void SetWorldRotation(const Vector3& rotation)
         {
-            Transform world_trans = Transform::TransformFromMatrix(world_matrix_);
+            Transform world_trans = GetWorldTransform();
             world_trans.SetRotation(rotation);
             SetWorldTransform(world_trans);
         }
 
         virtual void SetWorldRotation(const Quaternion& rotation)
         {
-            Transform world_trans = Transform::TransformFromMatrix(world_matrix_);
+            Transform world_trans = GetWorldTransform();
             world_trans.rotate_ = rotation;
             SetWorldTransform(world_trans);
         }
 
         virtual void AddWorldRotation(const Vector3& rotation)
         {
-            const auto world_trans = Transform::TransformFromMatrix(world_matrix_);
-            const auto new_quat = Transform::QuatFromRot(rotation) * world_trans.rotate_;
+            const auto new_quat = Transform::QuatFromRot(rotation) * GetWorldQuatRotation();
             SetWorldRotation(new_quat);
         }
 
         Vector3 GetWorldScale() const
         {
-            return Transform::TransformFromMatrix(world_matrix_).scale_;
+            return TransformSystem::GetInstance().GetWorldScale(id_);
         }
 
         virtual void SetWorldScale(const Vector3& scale)
         {
-            Transform world_trans = Transform::TransformFromMatrix(world_matrix_);
+            Transform world_trans = GetWorldTransform();
             world_trans.scale_ = scale;
             SetWorldTransform(world_trans);
         }
@@ -456,110 +484,79 @@ namespace GiiGa
 
         std::weak_ptr<TransformComponent> GetParent() const { return parent_; }
 
-        Matrix GetWorldMatrix() const { return world_matrix_; }
-        Matrix GetInverseWorldMatrix() const { return world_matrix_.Invert(); }
-        Matrix GetLocalMatrix() const { return local_matrix_; }
-        Matrix GetInverseLocalMatrix() const { return local_matrix_.Invert(); }
+        Matrix GetWorldMatrix() const { return TransformSystem::GetInstance().GetWorldMatrix(id_); }
+        Matrix GetInverseWorldMatrix() const { return GetWorldMatrix().Invert(); }
+        Matrix GetLocalMatrix() const { return TransformSystem::GetInstance().GetLocalMatrix(id_); }
+        Matrix GetInverseLocalMatrix() const { return GetLocalMatrix().Invert(); }
+
+        // id of this transform in TransformSystem
+        uint32_t GetTransformId() const { return id_; }
+
+        // changes every time the world matrix is recomputed, usable to skip redundant uploads
+        uint64_t GetWorldVersion() const { return TransformSystem::GetInstance().GetWorldVersion(id_); }
+
+        // fills world positions and rotations of transforms, output spans must be at least transforms.size() long
+        static void GetWorldPoses(std::span<const std::shared_ptr<TransformComponent>> transforms, std::span<Vector3> locations, std::span<Quaternion> rotations)
+        {
+            auto& system = TransformSystem::GetInstance();
+            for (size_t i = 0; i < transforms.size(); ++i)
+            {
+                locations[i] = system.GetWorldLocation(transforms[i]->id_);
+                rotations[i] = system.GetWorldRotation(transforms[i]->id_);
+            }
+        }
 
         void AttachTo(const std::weak_ptr<TransformComponent>& parent)
         {
             if (parent.expired() || parent.lock() == parent_.lock()) return;
             if (!parent_.expired()) Detach();
+            if (!TransformSystem::GetInstance().SetParent(id_, parent.lock()->id_))
+            {
+                el::Loggers::getLogger(LogWorld)->warn("TransformComponent::AttachTo() attaching %v would create a cycle", GetUuid().ToString());
+                return;
+            }
             parent_ = parent;
-            cashed_event_ = parent_.lock()->OnUpdateTransform.Register([this](const std::shared_ptr<TransformComponent>& e) { ParentUpdateTransform(e); });
-            UpdateTransformMatrices();
         }
 
         void Detach()
         {
             if (parent_.expired()) return;
-            parent_.lock()->OnUpdateTransform.Unregister(cashed_event_);
+            TransformSystem::GetInstance().SetParent(id_, TransformSystem::InvalidId);
             parent_.reset();
-            UpdateTransformMatrices();
         }
 
-        EventDispatcher<std::shared_ptr<TransformComponent>> OnUpdateTransform;
+        // combination of TransformAttach bits, parent components not listed are not inherited
+        uint8_t GetAttachFlags() const { return TransformSystem::GetInstance().GetAttachFlags(id_); }
+        void SetAttachFlags(uint8_t flags) { TransformSystem::GetInstance().SetAttachFlags(id_, flags); }
 
-        bool attach_translation = true;
-        bool attach_rotate = true;
-        bool attach_scale = true;
+        EventDispatcher<std::shared_ptr<TransformComponent>> OnUpdateTransform;
 
     protected:
-        bool is_dirty_ = true;
-        Transform transform_;
-        Matrix world_matrix_;
-        Matrix local_matrix_;
+        uint32_t id_ = TransformSystem::InvalidId;
         std::weak_ptr<TransformComponent> parent_;
-        EventHandle<std::shared_ptr<TransformComponent>> cashed_event_ = EventHandle<std::shared_ptr<TransformComponent>>::Null();
 
-    private:
-        void UpdateTransformMatrices()
+        void WriteTransform(const Transform& transform)
         {
-            const auto pref_local_matrix = local_matrix_;
-            local_matrix_ = transform_.GetMatrix();
-            if (!is_dirty_)
-            {
-                Matrix local_to_world = pref_local_matrix.Invert() * world_matrix_;
-                world_matrix_ = local_matrix_ * local_to_world;
-            }
-            else
-            {
-                CalcWorldTransformMatrix();
-                is_dirty_ = false;
-            }
-            OnUpdateTransform.Invoke(std::dynamic_pointer_cast<TransformComponent>(shared_from_this()));
+            TransformSystem::GetInstance().SetLocal(id_, transform.location_, transform.rotate_, transform.scale_);
         }
+    };
+#pragma endregion
 
-        void CalcWorldTransformMatrix()
-        {
-            auto rootComp = std::dynamic_pointer_cast<TransformComponent>(shared_from_this());
-            world_matrix_ = rootComp->local_matrix_;
-
-            auto parentComp = rootComp->parent_.lock();
-            while (parentComp)
-            {
-                if (rootComp->attach_translation && rootComp->attach_rotate && rootComp->attach_scale)
-                {
-                    world_matrix_ *= parentComp->local_matrix_;
-                }
-                else if (rootComp->attach_translation && rootComp->attach_rotate)
-                {
-                    world_matrix_.Translation(parentComp->local_matrix_.Translation());
-                    world_matrix_ *= world_matrix_.CreateFromYawPitchRoll(parentComp->local_matrix_.ToEuler());
-                }
-                else if (rootComp->attach_translation && rootComp->attach_scale)
-                {
-                    world_matrix_.Translation(parentComp->local_matrix_.Translation());
-                    world_matrix_ *= world_matrix_.CreateScale(parentComp->transform_.scale_);
-                }
-                else if (rootComp->attach_rotate && rootComp->attach_scale)
-                {
-                    world_matrix_ *= world_matrix_.CreateFromYawPitchRoll(parentComp->local_matrix_.ToEuler());
-                    world_matrix_ *= world_matrix_.CreateScale(parentComp->transform_.scale_);
-                }
-                else if (rootComp->attach_translation)
-                {
-                    world_matrix_.Translation(parentComp->local_matrix_.Translation());
-                }
-                else if (rootComp->attach_rotate)
-                {
-                    world_matrix_ *= world_matrix_.CreateFromYawPitchRoll(parentComp->local_matrix_.ToEuler());
-                }
-                else if (rootComp->attach_scale)
-                {
-                    world_matrix_ *= world_matrix_.CreateScale(parentComp->transform_.scale_);
-                }
+    // Runs after the whole frame wrote transforms. Listeners that copy transforms into another system
+    // (physics) must ignore changes they wrote themselves, pushing those back overwrites that system's newer state.
+    inline void TransformSystem::NotifyChanged()
+    {
+        if (changed_ids_.empty()) return;
 
-                rootComp = parentComp;
-                parentComp = rootComp->parent_.lock();
-            }
-        }
+        OnTransformsChanged.Invoke(std::span<const uint32_t>(changed_ids_));
 
-        void ParentUpdateTransform(const std::shared_ptr<TransformComponent>& e)
+        for (const uint32_t id : changed_ids_)
         {
-            is_dirty_ = true;
-            UpdateTransformMatrices();
+            // owners may be destroyed by callbacks of previous entries
+            TransformComponent* owner = GetOwner(id);
+            if (!owner || !owner->OnUpdateTransform.HasHandlers()) continue;
+            if (auto l_owner = std::dynamic_pointer_cast<TransformComponent>(owner->weak_from_this().lock()))
+                l_owner->OnUpdateTransform.Invoke(l_owner);
         }
-    };
-#pragma endregion
+    }
 }
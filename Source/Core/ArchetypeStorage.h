@@ -0,0 +1,170 @@
+#pragma once
+#include<algorithm>
+#include<array>
+#include<map>
+#include<memory>
+#include<span>
+#include<typeindex>
+#include<unordered_map>
+#include<utility>
+#include<vector>
+
+#include<IComponent.h>
+#include<IGameObject.h>
+#include<ComponentAllocator.h>
+
+namespace GiiGa
+{
+    /*
+     * Game objects grouped by the set of their component types.
+     * Every archetype keeps one dense column of component pointers per type in its signature,
+     * so queries walk contiguous arrays of exactly matching components without casts or per-object lookups.
+     * GameObject keeps its component list as before and re-files itself here when the list changes.
+     */
+    class ArchetypeStorage
+    {
+    public:
+        struct Archetype
+        {
+            // sorted, a type repeats when an object has several components of it
+            std::vector<std::type_index> types;
+            std::vector<IGameObject*> owners;
+            // columns[column][row]
+            std::vector<std::vector<IComponent*>> columns;
+        };
+
+        static ArchetypeStorage& GetInstance()
+        {
+            if (!instance_) instance_ = std::make_unique<ArchetypeStorage>();
+            return *instance_;
+        }
+
+        void Assign(IGameObject* owner, std::span<const std::shared_ptr<IComponent>> components)
+        {
+            signature_scratch_.clear();
+            for (const auto& component : components)
+            {
+                if (component) signature_scratch_.emplace_back(std::type_index(typeid(*component)), component.get());
+            }
+            std::stable_sort(signature_scratch_.begin(), signature_scratch_.end(), [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+
+            types_scratch_.clear();
+            for (const auto& [type, _] : signature_scratch_)
+                types_scratch_.push_back(type);
+
+            auto [it, inserted] = archetype_of_signature_.try_emplace(types_scratch_, static_cast<uint32_t>(archetypes_.size()));
+            if (inserted)
+            {
+                auto archetype = std::make_unique<Archetype>();
+                archetype->types = types_scratch_;
+                archetype->columns.resize(types_scratch_.size());
+                archetypes_.push_back(std::move(archetype));
+            }
+            const uint32_t archetype_index = it->second;
+
+            auto location = locations_.find(owner);
+            if (location != locations_.end() && location->second.first != archetype_index)
+            {
+                RemoveRow(location->second.first, location->second.second);
+                locations_.erase(location);
+                location = locations_.end();
+            }
+
+            auto& archetype = *archetypes_[archetype_index];
+            uint32_t row;
+            if (location == locations_.end())
+            {
+                row = static_cast<uint32_t>(archetype.owners.size());
+                archetype.owners.push_back(owner);
+                for (auto& column : archetype.columns)
+                    column.push_back(nullptr);
+                locations_.emplace(owner, std::pair{archetype_index, row});
+            }
+            else
+            {
+                row = location->second.second;
+            }
+
+            for (size_t c = 0; c < signature_scratch_.size(); ++c)
+                archetype.columns[c][row] = signature_scratch_[c].second;
+        }
+
+        void Remove(const IGameObject* owner)
+        {
+            auto location = locations_.find(owner);
+            if (location == locations_.end()) return;
+
+            RemoveRow(location->second.first, location->second.second);
+            locations_.erase(location);
+        }
+
+        // Calls fn(IGameObject&, Ts&...) for every game object having components of exactly each of Ts.
+        // fn must not add or remove components.
+        template <typename... Ts, typename Fn>
+        void ForEach(Fn&& fn)
+        {
+            static_assert((std::is_base_of_v<IComponent, Ts> && ...), "Ts must be derived from IComponent");
+
+            for (const auto& archetype : archetypes_)
+            {
+                if (archetype->owners.empty()) continue;
+
+                std::array<size_t, sizeof...(Ts)> columns{};
+                bool matches = true;
+                size_t index = 0;
+                ((matches = matches && FindColumn(*archetype, typeid(Ts), columns[index++])), ...);
+                if (!matches) continue;
+
+                ForEachRow<Ts...>(*archetype, columns, fn, std::index_sequence_for<Ts...>{});
+            }
+        }
+
+        const std::vector<std::unique_ptr<Archetype>>& GetArchetypes() const
+        {
+            return archetypes_;
+        }
+
+    private:
+        static inline std::unique_ptr<ArchetypeStorage> instance_ = nullptr;
+
+        std::vector<std::unique_ptr<Archetype>> archetypes_;
+        std::map<std::vector<std::type_index>, uint32_t> archetype_of_signature_;
+        // game object -> {archetype, row}
+        std::unordered_map<const IGameObject*, std::pair<uint32_t, uint32_t>> locations_;
+
+        std::vector<std::pair<std::type_index, IComponent*>> signature_scratch_;
+        std::vector<std::type_index> types_scratch_;
+
+        static bool FindColumn(const Archetype& archetype, const std::type_info& type, size_t& column)
+        {
+            const auto it = std::lower_bound(archetype.types.begin(), archetype.types.end(), std::type_index(type));
+            if (it == archetype.types.end() || *it != std::type_index(type)) return false;
+            column = static_cast<size_t>(it - archetype.types.begin());
+            return true;
+        }
+
+        template <typename... Ts, typename Fn, size_t... I>
+        static void ForEachRow(Archetype& archetype, const std::array<size_t, sizeof...(Ts)>& columns, Fn& fn, std::index_sequence<I...>)
+        {
+            const std::array<IComponent* const*, sizeof...(Ts)> data{archetype.columns[columns[I]].data()...};
+            for (size_t row = 0; row < archetype.owners.size(); ++row)
+                fn(*archetype.owners[row], *static_cast<Ts*>(data[I][row])...);
+        }
+
+        void RemoveRow(uint32_t archetype_index, uint32_t row)
+        {
+            auto& archetype = *archetypes_[archetype_index];
+            const uint32_t last = static_cast<uint32_t>(archetype.owners.size() - 1);
+            if (row != last)
+            {
+                archetype.owners[row] = archetype.owners[last];
+                for (auto& column : archetype.columns)
+                    column[row] = column[last];
+                locations_[archetype.owners[row]].second = row;
+            }
+            archetype.owners.pop_back();
+            for (auto& column : archetype.columns)
+                column.pop_back();
+        }
+    };
+}
@@ -93,8 +93,12 @@ namespace GiiGa
             Uuid world_root_uuid = prefab_uuid_to_world_uuid[prefab_root_uuid];
             
             auto root_go = WorldQuery::GetWithUUID<GameObject>(world_root_uuid);
+            // prototype is only a source for instances, it does not tick, render or simulate
+            root_go->Deactivate();
 
-            return std::make_shared<PrefabAsset>(handle, root_go);
+            auto prefab = std::make_shared<PrefabAsset>(handle, root_go);
+            prefab->CompileTemplate();
+            return prefab;
         }
 
         void Save(std::shared_ptr<AssetBase> asset, const std::filesystem::path& path) override
@@ -4,7 +4,10 @@
 #include<json/value.h>
 #include<memory>
 #include<optional>
+#include<span>
+#include<stdexcept>
 #include<unordered_set>
+#include<vector>
 
 #include<AssetBase.h>
 #include<GameObject.h>
@@ -36,6 +39,8 @@ namespace GiiGa
             result["RootGameObject"] = root->GetUuid().ToString();
 
             std::vector<Json::Value> go_with_kids = RecurGOToJsonWithKids(std::dynamic_pointer_cast<GameObject>(root), true);
+            // saved prototype may have been edited
+            CompileTemplate();
 
             for (auto&& go : go_with_kids)
             {
@@ -63,12 +68,86 @@ namespace GiiGa
         std::shared_ptr<GameObject> Instantiate(const std::optional<std::unordered_map<Uuid, Uuid>>& instance_uuid,
                                                 const std::optional<std::unordered_set<Uuid>>& removed_gos_comps)
         {
+            if (!instance_uuid && !removed_gos_comps)
+                return InstantiateMany(1).front();
+
             std::unordered_map<Uuid, Uuid> prefab_uuid_to_world;
             auto new_go = root->Clone(prefab_uuid_to_world, instance_uuid, removed_gos_comps);
             new_go->RestoreFromOriginal(root, prefab_uuid_to_world);
             return new_go;
         }
 
+        // Stamps count instances from compiled template, no per instance traversal of the prototype.
+        // Root still living in a scene (prefab saved from scene) may be edited any time, it is cloned whole instead.
+        // transforms is either empty or holds root transform of every instance.
+        std::vector<std::shared_ptr<GameObject>> InstantiateMany(size_t count, std::span<const Transform> transforms = {})
+        {
+            if (!transforms.empty() && transforms.size() != count)
+                throw std::runtime_error("InstantiateMany expects one transform per instance");
+
+            if (root->IsActive())
+                return CloneMany(count, transforms);
+
+            const PrefabTemplate& compiled = GetTemplate();
+            WorldQuery::ReserveRegistrations(count * compiled.uuid_slots, count * compiled.component_count);
+
+            std::vector<std::shared_ptr<GameObject>> instances;
+            instances.reserve(count);
+            std::vector<std::shared_ptr<GameObject>> clones(compiled.nodes.size());
+            std::unordered_map<Uuid, Uuid> prefab_uuid_to_world;
+            prefab_uuid_to_world.reserve(compiled.uuid_slots);
+
+            for (size_t n = 0; n < count; ++n)
+            {
+                prefab_uuid_to_world.clear();
+                for (size_t i = 0; i < compiled.nodes.size(); ++i)
+                {
+                    const auto& node = compiled.nodes[i];
+                    clones[i] = node.source->CloneWithoutChildren(prefab_uuid_to_world, std::nullopt, std::nullopt, node.transform_slot);
+                    if (node.parent >= 0)
+                        clones[i]->SetParent(clones[node.parent]);
+                }
+
+                // children resolve their references before parents, same as RestoreFromOriginal
+                for (size_t i = compiled.nodes.size(); i-- > 0;)
+                    clones[i]->RestoreComponentsFromOriginal(compiled.nodes[i].source, prefab_uuid_to_world);
+
+                if (!transforms.empty())
+                    clones.front()->GetTransformComponent().lock()->SetTransform(transforms[n]);
+                instances.push_back(clones.front());
+            }
+
+            return instances;
+        }
+
+        // flattens prototype hierarchy, call again after prototype was edited
+        void CompileTemplate()
+        {
+            template_ = PrefabTemplate{};
+            template_.root = root;
+            if (!root) return;
+
+            template_.nodes.push_back({root, -1, std::nullopt});
+            for (size_t i = 0; i < template_.nodes.size(); ++i)
+            {
+                const auto source = template_.nodes[i].source;
+                const auto& components = source->GetComponents();
+                for (size_t c = 0; c < components.size(); ++c)
+                {
+                    if (std::dynamic_pointer_cast<TransformComponent>(components[c]))
+                    {
+                        template_.nodes[i].transform_slot = c;
+                        break;
+                    }
+                }
+                template_.component_count += components.size();
+
+                for (const auto& kid : source->GetChildren())
+                    template_.nodes.push_back({kid, static_cast<int32_t>(i), std::nullopt});
+            }
+            template_.uuid_slots = template_.nodes.size() + template_.component_count;
+        }
+
         std::vector<Json::Value> RecurGOToJsonWithKids(std::shared_ptr<GameObject> go, bool is_root = false)
         {
             std::vector<Json::Value> jsons;
@@ -97,6 +176,51 @@ namespace GiiGa
         }
 
         std::shared_ptr<GameObject> root;
+
+    private:
+        // prototype hierarchy flattened once, parents always come before their children
+        struct PrefabTemplate
+        {
+            struct Node
+            {
+                std::shared_ptr<GameObject> source;
+                int32_t parent;
+                std::optional<size_t> transform_slot;
+            };
+
+            std::shared_ptr<GameObject> root;
+            std::vector<Node> nodes;
+            size_t component_count = 0;
+            // uuids one instance registers, game objects and components
+            size_t uuid_slots = 0;
+        };
+
+        PrefabTemplate template_;
+
+        const PrefabTemplate& GetTemplate()
+        {
+            if (template_.root != root)
+                CompileTemplate();
+            return template_;
+        }
+
+        std::vector<std::shared_ptr<GameObject>> CloneMany(size_t count, std::span<const Transform> transforms)
+        {
+            std::vector<std::shared_ptr<GameObject>> instances;
+            instances.reserve(count);
+            for (size_t n = 0; n < count; ++n)
+            {
+                std::unordered_map<Uuid, Uuid> prefab_uuid_to_world;
+                auto new_go = root->Clone(prefab_uuid_to_world, std::nullopt, std::nullopt);
+                new_go->RestoreFromOriginal(root, prefab_uuid_to_world);
+                if (!transforms.empty())
+                    new_go->GetTransformComponent().lock()->SetTransform(transforms[n]);
+                instances.push_back(std::move(new_go));
+            }
+            return instances;
+        }
+
+    public:
         
         AssetType GetType() override
         {
@@ -18,10 +18,16 @@ namespace GiiGa
     class Component : public IComponent
     {
     public:
-        Component() = default;
+        // components do not tick unless derived class picks a tick group
+        Component()
+        {
+            tick_type = TickType::None;
+        }
 
         Component(const Json::Value& json, bool roll_id = false)
         {
+            tick_type = TickType::None;
+
             auto js_uuid = Uuid::FromString(json["Uuid"].asString());
 
             if (!js_uuid.has_value())
@@ -46,6 +52,17 @@ namespace GiiGa
 
         void Destroy() override
         {
+            if (destroy_pending_) return;
+            destroy_pending_ = true;
+            WorldQuery::DeferDestroy(shared_from_this());
+        }
+
+        // leaves world and owner, object itself lives until world drops last reference
+        void DestroyImmediate() override
+        {
+            WorldQuery::RemoveComponent(this);
+            WorldQuery::TryRemoveAnyWithUuid(uuid_);
+            OnPoolRelease();
             if (auto l_owner = owner_.lock())
             {
                 l_owner->RemoveComponent(shared_from_this());
@@ -56,7 +73,7 @@ namespace GiiGa
         {
             //el::Loggers::getLogger("")->debug("Component::~Component");
             WorldQuery::RemoveComponent(this);
-            WorldQuery::RemoveAnyWithUuid(uuid_);
+            WorldQuery::TryRemoveAnyWithUuid(uuid_);
         }
 
         virtual void SetOwner(std::shared_ptr<IGameObject> go) override
@@ -78,6 +95,30 @@ namespace GiiGa
         {
         }
 
+        bool IsTickEnabled() const override
+        {
+            const auto owner = owner_.lock();
+            return enabled && initialized && !begin_play_pending && owner && owner->IsActive() && owner->IsInActiveLevel() && owner->tick_type != TickType::None;
+        }
+
+        void OnPoolRelease() override
+        {
+        }
+
+        void OnPoolAcquire() override
+        {
+        }
+
+        TickAccess GetTickAccess() const override
+        {
+            return TickAccess::Undeclared();
+        }
+
+        InitPriority GetInitPriority() const override
+        {
+            return InitPriority::Default;
+        }
+
         Uuid GetInPrefabUuid() const override
         {
             return inprefab_uuid_;
@@ -107,8 +148,15 @@ namespace GiiGa
         Uuid uuid_ = Uuid::New();
         Uuid inprefab_uuid_ = Uuid::Null();
         bool enabled = true;
+        bool destroy_pending_ = false;
         std::weak_ptr<IGameObject> owner_;
 
+        bool IsOwnerActive() const
+        {
+            const auto owner = owner_.lock();
+            return !owner || owner->IsActive();
+        }
+
         void CloneBase(std::shared_ptr<Component> derived_clone, std::unordered_map<Uuid, Uuid>& prefab_uuid_to_world_uuid,
                        const std::optional<std::unordered_map<Uuid, Uuid>>& instance_uuid) const
         {
@@ -0,0 +1,124 @@
+#pragma once
+#include<algorithm>
+#include<cstddef>
+#include<cstdint>
+#include<memory>
+#include<mutex>
+#include<new>
+#include<utility>
+#include<vector>
+
+namespace GiiGa
+{
+    struct ArchetypeStorageSettings
+    {
+        // components made through MakeComponent come from per-type chunks and game objects are grouped by archetype,
+        // set before the first component is created
+        static inline bool Enabled = false;
+        static inline uint32_t ObjectsPerChunk = 64;
+    };
+
+    /*
+     * Fixed-size slots carved from chunks of ObjectsPerChunk, one pool per (size, alignment).
+     * Consecutive allocations of one type land next to each other, freed slots are reused.
+     * Pools are never destroyed, objects may outlive static destruction.
+     */
+    template <size_t Size, size_t Align>
+    class ChunkPool
+    {
+    public:
+        static ChunkPool& Get()
+        {
+            static ChunkPool* pool = new ChunkPool();
+            return *pool;
+        }
+
+        void* Allocate()
+        {
+            std::lock_guard lock(mutex_);
+            if (!free_) Grow();
+            FreeSlot* slot = free_;
+            free_ = slot->next;
+            return slot;
+        }
+
+        void Deallocate(void* pointer)
+        {
+            std::lock_guard lock(mutex_);
+            auto* slot = static_cast<FreeSlot*>(pointer);
+            slot->next = free_;
+            free_ = slot;
+        }
+
+    private:
+        struct FreeSlot
+        {
+            FreeSlot* next;
+        };
+
+        static constexpr size_t SlotAlign = std::max(Align, alignof(FreeSlot));
+        static constexpr size_t SlotSize = (std::max(Size, sizeof(FreeSlot)) + SlotAlign - 1) / SlotAlign * SlotAlign;
+
+        std::mutex mutex_;
+        FreeSlot* free_ = nullptr;
+        std::vector<std::byte*> chunks_;
+
+        void Grow()
+        {
+            const size_t count = std::max<uint32_t>(1, ArchetypeStorageSettings::ObjectsPerChunk);
+            auto* chunk = static_cast<std::byte*>(::operator new(SlotSize * count, std::align_val_t{SlotAlign}));
+            chunks_.push_back(chunk);
+
+            // linked back to front so slots are handed out in address order
+            for (size_t i = count; i-- > 0;)
+            {
+                auto* slot = reinterpret_cast<FreeSlot*>(chunk + i * SlotSize);
+                slot->next = free_;
+                free_ = slot;
+            }
+        }
+    };
+
+    // single-object allocations go to ChunkPool, used with allocate_shared so control block shares the slot
+    template <typename T>
+    struct ComponentAllocator
+    {
+        using value_type = T;
+
+        ComponentAllocator() = default;
+
+        template <typename U>
+        ComponentAllocator(const ComponentAllocator<U>&) noexcept
+        {
+        }
+
+        T* allocate(size_t n)
+        {
+            if (n == 1)
+                return static_cast<T*>(ChunkPool<sizeof(T), alignof(T)>::Get().Allocate());
+            return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t{alignof(T)}));
+        }
+
+        void deallocate(T* pointer, size_t n) noexcept
+        {
+            if (n == 1)
+                ChunkPool<sizeof(T), alignof(T)>::Get().Deallocate(pointer);
+            else
+                ::operator delete(pointer, std::align_val_t{alignof(T)});
+        }
+
+        template <typename U>
+        bool operator==(const ComponentAllocator<U>&) const noexcept
+        {
+            return true;
+        }
+    };
+
+    template <typename T, typename... Args>
+    std::shared_ptr<T> MakeComponent(Args&&... args)
+    {
+        if (ArchetypeStorageSettings::Enabled)
+            return std::allocate_shared<T>(ComponentAllocator<T>{}, std::forward<Args>(args)...);
+        return std::make_shared<T>(std::forward<Args>(args)...);
+    }
+}
@@ -6,6 +6,7 @@
 #include<EditorRenderSystem.h>
 #include<EditorAssetDatabase.h>
 #include"World.h"
+#include<TransformSystem.h>
 #include<DDSAssetLoader.h>
 #include<ImageAssetLoader.h>
 #include<MeshAssetLoader.h>
@@ -31,9 +32,14 @@ namespace GiiGa
                 window_->ProcessEvents();
                 CheckAssetUpdateQueue();
                 Timer::UpdateTime();
-                World::Tick(static_cast<float>(Timer::GetDeltaTime()));
-                if (World::GetInstance().GetState() == WorldState::Play) PhysicsSystem::Simulate(static_cast<float>(Timer::GetDeltaTime()));
+                const float dt = static_cast<float>(Timer::GetDeltaTime());
+                World::Tick(dt);
+                if (World::GetInstance().GetState() == WorldState::Play) PhysicsSystem::Simulate(dt);
+                World::TickGroup(TickType::PostPhysics, dt);
+                World::TickGroup(TickType::PreRender, dt);
+                TransformSystem::Update();
                 render_system_->Tick();
+                World::FlushDestroyed();
             }
 
             DeInitialize();
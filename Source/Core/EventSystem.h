@@ -79,6 +79,11 @@ namespace GiiGa
             handlers_.erase(id.id_); 
         }
 
+        bool HasHandlers() const
+        {
+            return !handlers_.empty();
+        }
+
         void Invoke(const T& event) const
         {
             for (const auto& [id, handler] : handlers_)
@@ -12,6 +12,7 @@
 #include<Timer.h>
 #include<RenderSystem.h>
 #include<World.h
+#include<TransformSystem.h>
 
 namespace GiiGa
 {
@@ -39,20 +40,13 @@ namespace GiiGa
                     quit_ = true;
                 }
                 Timer::UpdateTime();
-                for (auto& level : World::GetLevels())
-                {
-                    if (!level->GetIsActive())
-                    {
-                        continue;
-                    }
-                    const auto& level_root_gos = level->GetRootGameObjects();
-                    for (int i = 0; i < level_root_gos.size(); ++i)
-                    {
-                        if (level_root_gos[i]->tick_type == TickType::Default)
-                            level_root_gos[i]->Tick(Timer::GetDeltaTime());
-                    }
-                }
+                const float dt = static_cast<float>(Timer::GetDeltaTime());
+                World::Tick(dt);
+                World::TickGroup(TickType::PostPhysics, dt);
+                World::TickGroup(TickType::PreRender, dt);
+                TransformSystem::Update();
                 render_system_->Tick();
+                World::FlushDestroyed();
             }
         }
     };
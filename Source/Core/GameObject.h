@@ -20,6 +20,7 @@
 #include<PerObjectData.h>
 #include<AssetHandle.h>
 #include<PrefabInstanceModifications.h>
+#include<ArchetypeStorage.h>
 
 namespace GiiGa
 {
@@ -45,15 +46,55 @@ namespace GiiGa
 
         void Destroy() override
         {
-            TryDetachFromParent();
+            if (destroy_pending_) return;
+            destroy_pending_ = true;
+            WorldQuery::DeferDestroy(shared_from_this());
+        }
+
+        // leaves hierarchy and world with whole subtree, objects themselves live until world drops last reference
+        void DestroyImmediate() override
+        {
+            Deactivate();
+            UnregisterFromWorld();
+        }
+
+        bool IsActive() const override
+        {
+            return active_;
+        }
+
+        bool IsInActiveLevel() const override
+        {
+            const auto level = level_root_gos_.lock();
+            return level && level->GetIsActive();
+        }
 
+        // leaves level and deactivates whole hierarchy, used by pools and prefab prototypes,
+        // object stays registered in world until activated again
+        void Deactivate()
+        {
+            if (!active_) return;
+
+            TryDetachFromParent();
             TryRemoveFromLevelRoot();
+            RecurSetLevel(nullptr);
+            SetActiveRecursive(false);
+        }
+
+        void Activate(std::shared_ptr<ILevelRootGameObjects> level_rgo)
+        {
+            if (active_) return;
+
+            AttachToLevelRoot(level_rgo);
+            RecurSetLevel(level_rgo);
+            SetActiveRecursive(true);
         }
 
         ~GameObject() override
         {
             //el::Loggers::getLogger("")->debug("GameObject::~GameObject");
-            WorldQuery::RemoveAnyWithUuid(uuid_);
+            WorldQuery::TryRemoveAnyWithUuid(uuid_);
+            ArchetypeStorage::GetInstance().Remove(this);
         }
 
         GameObject(const GameObject& other) = delete;
@@ -89,7 +130,8 @@ namespace GiiGa
 
         void RemoveComponent(std::shared_ptr<IComponent> comp) override
         {
-            components_.erase(std::remove(components_.begin(), components_.end(), comp));
+            if (std::erase(components_, comp) == 0) return;
+            UpdateArchetype();
         }
 
         void AttachToLevelRoot(std::shared_ptr<ILevelRootGameObjects> level_rgo)
@@ -417,16 +459,26 @@ namespace GiiGa
                 this->children_[i]->RestoreFromOriginal(original->children_[i], original_uuid_to_world);
             }
 
+            RestoreComponentsFromOriginal(original, original_uuid_to_world);
+        }
+
+        // own components only, children are up to caller
+        void RestoreComponentsFromOriginal(const std::shared_ptr<GameObject>& original, const std::unordered_map<Uuid, Uuid>& original_uuid_to_world)
+        {
             for (int i = 0; i < original->components_.size(); ++i)
             {
                 this->components_[i]->RestoreFromOriginal(original->components_[i], original_uuid_to_world);
             }
         }
 
+        // world ticks components through tick groups, this ticks one hierarchy by hand
         void Tick(float dt) override
         {
             for (int i = 0; i < components_.size(); ++i)
-                components_[i]->Tick(dt);
+            {
+                if (components_[i]->tick_type != TickType::None)
+                    components_[i]->Tick(dt);
+            }
 
             for (int i = 0; i < children_.size(); ++i)
                 children_[i]->Tick(dt);
@@ -435,10 +487,11 @@ namespace GiiGa
         template <typename T, typename... Args>
         std::shared_ptr<T> CreateComponent(const Args&... args)
         {
-            if (std::shared_ptr<T> newComp = std::make_shared<T>(args...))
+            if (std::shared_ptr<T> newComp = MakeComponent<T>(args...))
             {
                 newComp->SetOwner(std::static_pointer_cast<GameObject>(shared_from_this()));
                 components_.push_back(newComp);
+                UpdateArchetype();
                 newComp->RegisterInWorld();
                 return newComp;
             }
@@ -450,6 +503,7 @@ namespace GiiGa
         {
             comp->SetOwner(shared_from_this());
             components_.push_back(comp);
+            UpdateArchetype();
         }
 
         template <typename T>
@@ -490,6 +544,28 @@ namespace GiiGa
             std::unordered_map<Uuid, Uuid>& prefab_uuid_to_world_uuid,
             const std::optional<std::unordered_map<Uuid, Uuid>>& instance_uuid,
             const std::optional<std::unordered_set<Uuid>>& removed_gos_comps)
+        {
+            auto newGameObject = CloneWithoutChildren(prefab_uuid_to_world_uuid, instance_uuid, removed_gos_comps);
+
+            for (auto&& kid : children_)
+            {
+                if (!removed_gos_comps.has_value() || !removed_gos_comps.value().contains(kid->GetInPrefabUuid()))
+                {
+                    auto kid_clone = kid->Clone(prefab_uuid_to_world_uuid, instance_uuid, removed_gos_comps);
+                    kid_clone->SetParent(newGameObject);
+                }
+            }
+
+            return newGameObject;
+        }
+
+        // game object with its components, children are up to caller,
+        // transform_slot is index of transform among components when caller already knows it
+        std::shared_ptr<GameObject> CloneWithoutChildren(
+            std::unordered_map<Uuid, Uuid>& prefab_uuid_to_world_uuid,
+            const std::optional<std::unordered_map<Uuid, Uuid>>& instance_uuid,
+            const std::optional<std::unordered_set<Uuid>>& removed_gos_comps,
+            std::optional<size_t> transform_slot = std::nullopt)
         {
             auto newGameObject = std::shared_ptr<GameObject>(new GameObject());
 
@@ -510,20 +586,17 @@ namespace GiiGa
                     newGameObject->AddComponent(component->Clone(prefab_uuid_to_world_uuid, instance_uuid));
             }
 
-            if (auto opt_trans_comp = newGameObject->GetComponent<TransformComponent>())
+            std::shared_ptr<TransformComponent> slot_transform;
+            if (transform_slot && !removed_gos_comps.has_value() && transform_slot.value() < newGameObject->components_.size())
+                slot_transform = std::dynamic_pointer_cast<TransformComponent>(newGameObject->components_[transform_slot.value()]);
+
+            if (slot_transform)
+                newGameObject->transform_ = slot_transform;
+            else if (auto opt_trans_comp = newGameObject->GetComponent<TransformComponent>())
                 newGameObject->transform_ = opt_trans_comp;
             else
                 throw std::exception("Failed to find transform component");
 
-            for (auto&& kid : children_)
-            {
-                if (!removed_gos_comps.has_value() || !removed_gos_comps.value().contains(kid->GetInPrefabUuid()))
-                {
-                    auto kid_clone = kid->Clone(prefab_uuid_to_world_uuid, instance_uuid, removed_gos_comps);
-                    kid_clone->SetParent(newGameObject);
-                }
-            }
-
             return newGameObject;
         }
 
@@ -606,6 +679,43 @@ namespace GiiGa
 
         std::shared_ptr<PerObjectData> perObjectData_;
 
+        bool active_ = true;
+        bool destroy_pending_ = false;
+
+        void SetActiveRecursive(bool active)
+        {
+            active_ = active;
+            for (int i = 0; i < components_.size(); ++i)
+            {
+                if (active)
+                    components_[i]->OnPoolAcquire();
+                else
+                    components_[i]->OnPoolRelease();
+            }
+
+            for (auto& kid : children_)
+                kid->SetActiveRecursive(active);
+        }
+
+        void UnregisterFromWorld()
+        {
+            for (auto& component : components_)
+            {
+                WorldQuery::RemoveComponent(component.get());
+                WorldQuery::TryRemoveAnyWithUuid(component->GetUuid());
+            }
+            WorldQuery::TryRemoveAnyWithUuid(uuid_);
+
+            for (auto& kid : children_)
+                kid->UnregisterFromWorld();
+        }
+
+        void UpdateArchetype()
+        {
+            if (ArchetypeStorageSettings::Enabled)
+                ArchetypeStorage::GetInstance().Assign(this, components_);
+        }
+
         void TryRemoveFromLevelRoot()
         {
             auto l_level = level_root_gos_.lock();
@@ -0,0 +1,89 @@
+#pragma once
+#include<memory>
+#include<optional>
+#include<stdexcept>
+#include<vector>
+
+#include<GameObject.h>
+#include<ConcreteAsset/PrefabAsset.h>
+#include<IWorldQuery.h>
+
+namespace GiiGa
+{
+    /*
+     * Keeps released instances of one prefab alive for reuse.
+     * Released game objects are out of level and do not tick, render or simulate,
+     * they keep their uuids and world registration so acquiring does not allocate.
+     * Components reset own state in OnPoolRelease / OnPoolAcquire.
+     */
+    class GameObjectPool
+    {
+    public:
+        explicit GameObjectPool(std::shared_ptr<PrefabAsset> prefab):
+            prefab_(std::move(prefab))
+        {
+            if (!prefab_)
+                throw std::runtime_error("GameObjectPool needs a prefab");
+        }
+
+        GameObjectPool(const GameObjectPool&) = delete;
+        GameObjectPool& operator=(const GameObjectPool&) = delete;
+
+        ~GameObjectPool()
+        {
+            Clear();
+        }
+
+        // instances are created released, their components get Init on next world tick as usual
+        void Prewarm(size_t count)
+        {
+            free_.reserve(free_.size() + count);
+            for (size_t i = 0; i < count; ++i)
+            {
+                auto instance = prefab_->Instantiate(std::nullopt, std::nullopt);
+                instance->Deactivate();
+                free_.push_back(std::move(instance));
+            }
+        }
+
+        // instantiates a new one when pool is empty, level defaults to persistent level
+        std::shared_ptr<GameObject> Acquire(const Transform& transform, std::shared_ptr<ILevelRootGameObjects> level_rgo = nullptr)
+        {
+            if (free_.empty())
+                Prewarm(1);
+
+            auto instance = std::move(free_.back());
+            free_.pop_back();
+
+            if (auto transform_component = instance->GetTransformComponent().lock())
+                transform_component->SetTransform(transform);
+            instance->Activate(level_rgo ? std::move(level_rgo) : WorldQuery::GetPersistentLevel());
+            return instance;
+        }
+
+        void Release(const std::shared_ptr<GameObject>& instance)
+        {
+            if (!instance || !instance->IsActive()) return;
+
+            instance->Deactivate();
+            free_.push_back(instance);
+        }
+
+        size_t FreeCount() const
+        {
+            return free_.size();
+        }
+
+        // destroys released instances, acquired ones stay with their owners
+        void Clear()
+        {
+            for (auto& instance : free_)
+                instance->Destroy();
+            free_.clear();
+        }
+
+    private:
+        std::shared_ptr<PrefabAsset> prefab_;
+        std::vector<std::shared_ptr<GameObject>> free_;
+    };
+}
@@ -7,6 +7,8 @@
 #include<optional>
 
 #include<ITickable.h>
+#include<InitQueue.h>
+#include<TickAccess.h>
 #include<Uuid.h>
 #include<IGameObject.h>
 #include<PrefabInstanceModifications.h>
@@ -36,12 +38,30 @@ namespace GiiGa
 
         virtual void Init() = 0;
 
+        // place in init and begin play queues, asked when component is queued
+        virtual InitPriority GetInitPriority() const = 0;
+
+        // checked before every Tick of a component registered in a tick group
+        virtual bool IsTickEnabled() const = 0;
+
+        // asked once per dynamic type when its first component enters a tick group
+        virtual TickAccess GetTickAccess() const = 0;
+
         virtual void BeginPlay() = 0;
         
         virtual void EndPlay() = 0;
 
+        // Destroy queues, world takes queued components apart with DestroyImmediate at frame end
         virtual void Destroy() =0;
 
+        virtual void DestroyImmediate() =0;
+
+        // called when owner is deactivated for a pool or as prefab prototype and when component is destroyed,
+        // pooled components stay registered in world between uses
+        virtual void OnPoolRelease() =0;
+
+        virtual void OnPoolAcquire() =0;
+
         virtual Uuid GetUuid() const = 0;
 
         virtual Uuid GetInPrefabUuid() const = 0;
@@ -53,5 +73,10 @@ namespace GiiGa
         virtual void OnOverlapping(const std::shared_ptr<CollisionComponent>& other_comp, const CollideInfo& collideInfo) = 0;
 
         virtual void OnEndOverlap(const std::shared_ptr<CollisionComponent>& other_comp) = 0;
+
+        // set by world after Init from init queue, component does not tick before
+        bool initialized = false;
+        // set while component waits in begin play queue, component does not tick and is not queued again meanwhile
+        bool begin_play_pending = false;
     };
 }
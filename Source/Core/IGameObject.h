@@ -23,8 +23,17 @@ namespace GiiGa
 
         virtual void RemoveComponent(std::shared_ptr<IComponent>) =0;
 
+        // Destroy queues, world takes queued objects apart with DestroyImmediate at frame end
         virtual void Destroy() =0;
 
+        virtual void DestroyImmediate() =0;
+
+        // false while game object waits in a pool
+        virtual bool IsActive() const =0;
+
+        // components of game objects outside an active level do not tick
+        virtual bool IsInActiveLevel() const =0;
+
         virtual Uuid GetInPrefabUuid() const =0;
 
         virtual void OnBeginOverlap(const std::shared_ptr<CollisionComponent>& other_comp, const CollideInfo& collideInfo) = 0;
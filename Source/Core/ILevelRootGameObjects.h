@@ -13,6 +13,8 @@ namespace GiiGa
     public:
         virtual ~ILevelRootGameObjects() = default;
 
+        virtual bool GetIsActive() const = 0;
+
         void AddRootGameObject(std::shared_ptr<IGameObject> rootGameObject)
         {
             root_game_objects_.push_back(rootGameObject);
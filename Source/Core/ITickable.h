@@ -2,10 +2,13 @@
 
 namespace GiiGa
 {
+    // groups run in this order every frame: PrePhysics, physics step, PostPhysics, PreRender, transforms, render
     enum TickType
     {
         None,
-        Default
+        PrePhysics,
+        PostPhysics,
+        PreRender
     };
 
     class ITickable
@@ -13,6 +16,7 @@ namespace GiiGa
     public:
         virtual ~ITickable() = default;
         virtual void Tick(float dt) =0;
-        TickType tick_type = Default;
+        // components tick in their group, game object set to None stops ticking of its components
+        TickType tick_type = PrePhysics;
     };
-}
\ No newline at end of file
+}
@@ -1,20 +1,34 @@
 #pragma once
 
 
+#include<algorithm>
+#include<array>
+#include<chrono>
+#include<deque>
 #include<unordered_map>
 #include<memory>
 #include<typeindex>
-#include<any>
 #include<stdexcept>
-#include<queue>
+#include<utility>
+#include<vector>
 
 #include<IComponent.h>
 #include<Uuid.h>
+#include<UuidFlatMap.h>
 #include<Logger.h>
 #include<ILevelRootGameObjects.h>
+#include<TickAccess.h>
+#include<InitQueue.h>
+#include<WorkerPool.h>
 
 namespace GiiGa
 {
+    struct DestroySettings
+    {
+        // time for destructors of destroyed objects per frame, rest waits for next frame, 0 releases everything
+        static inline double ReleaseBudgetMs = 0.0;
+    };
+
     class WorldQuery
     {
     public:
@@ -31,14 +45,18 @@ namespace GiiGa
             }
         }
 
-        static void AddAnyWithUuid(const Uuid& uuid, std::shared_ptr<void> value)
+        // components and game objects are remembered with their base so lookups cast from the right subobject
+        template <typename T>
+        static void AddAnyWithUuid(const Uuid& uuid, const std::shared_ptr<T>& value)
         {
-            auto& instance = GetInstance();
-            el::Loggers::getLogger(LogWorldQuery)->debug("Registering any with uuid %v", uuid.ToString());
-            if (instance.uuid_to_any_.contains(uuid))
-                throw std::runtime_error("Failed to AddAnyWithUuid, duplicated uuid!");
+            RegisteredObject object{value, RegisteredKind::Other};
+            if constexpr (std::is_base_of_v<IComponent, T>)
+                object = RegisteredObject{std::static_pointer_cast<IComponent>(value), RegisteredKind::Component};
+            else if constexpr (std::is_base_of_v<IGameObject, T>)
+                object = RegisteredObject{std::static_pointer_cast<IGameObject>(value), RegisteredKind::GameObject};
 
-            instance.uuid_to_any_.insert({uuid, value});
+            if (!GetInstance().uuid_to_any_.Insert(uuid, std::move(object)))
+                throw std::runtime_error("Failed to AddAnyWithUuid, duplicated or null uuid!");
         }
 
         static void RemoveAnyWithUuid(const Uuid& uuid)
@@ -46,76 +64,170 @@ namespace GiiGa
             if (uuid == Uuid::Null())
                 return;
 
-            if (!GetInstance().uuid_to_any_.contains(uuid))
+            if (!GetInstance().uuid_to_any_.Erase(uuid))
                 throw std::runtime_error("Failed to RemoveAnyWithUuid, not found uuid!");
-            el::Loggers::getLogger(LogWorldQuery)->debug("RemoveAnyWithUuid any with uuid %v", uuid.ToString());
-            GetInstance().uuid_to_any_.erase(uuid);
         }
 
+        // for destructors and batched destruction, object may already be unregistered
+        static bool TryRemoveAnyWithUuid(const Uuid& uuid)
+        {
+            if (!instance_ || uuid == Uuid::Null())
+                return false;
+
+            return instance_->uuid_to_any_.Erase(uuid);
+        }
+
+        // Returns nullptr when uuid is unknown, expired or registered as unrelated kind.
         template <typename T>
         static std::shared_ptr<T> GetWithUUID(const Uuid& uuid)
         {
-            auto inst = GetInstance();
+            const RegisteredObject* object = GetInstance().uuid_to_any_.Find(uuid);
+            if (!object) return nullptr;
 
-            if (!inst.uuid_to_any_.contains(uuid))
-                throw std::runtime_error("Failed to GetWithUUID, not found uuid!");
+            auto shared_ptr = object->value.lock();
+            if (!shared_ptr) return nullptr;
 
-            auto any = inst.uuid_to_any_.at(uuid);
-
-            std::shared_ptr<void> shared_ptr = nullptr;
-            try
+            if constexpr (std::is_base_of_v<IComponent, T>)
             {
-                auto weak_ptr = std::any_cast<std::weak_ptr<void>>(any);
-                if (weak_ptr.expired())
-                    throw std::runtime_error("Failed to get any of any with uuid! Something went wrong");
-                shared_ptr = weak_ptr.lock();
+                if (object->kind != RegisteredKind::Component) return nullptr;
+                return CastFromBase<T>(std::static_pointer_cast<IComponent>(std::move(shared_ptr)));
             }
-            catch (const std::exception& e)
+            else if constexpr (std::is_base_of_v<IGameObject, T>)
             {
-                el::Loggers::getLogger(LogWorldQuery)->fatal("Failed to get any of type %v", e.what());
+                if (object->kind != RegisteredKind::GameObject) return nullptr;
+                return CastFromBase<T>(std::static_pointer_cast<IGameObject>(std::move(shared_ptr)));
+            }
+            else
+            {
+                return std::static_pointer_cast<T>(std::move(shared_ptr));
             }
-
-            return std::static_pointer_cast<T>(shared_ptr);
         }
 
         template <typename T>
         static void AddComponent(std::shared_ptr<T> component)
         {
             static_assert(std::is_base_of<IComponent, T>::value, "T must be derived from Component");
-            GetInstance().comp_init_queue_.push(component);
-            //GetInstance().type_to_components_[typeid(*component)].push_back(component);
+            auto& inst = GetInstance();
+            inst.comp_init_queue_.Push(component, component->GetInitPriority());
+            ++inst.init_progress_.total;
+            inst.AddToTypeBucket(component);
+            GetInstance().AddToTickList(component);
+        }
+
+        // moves registered component to another tick group, unregistered one picks it up on registration
+        static void SetTickType(const std::shared_ptr<IComponent>& component, TickType type)
+        {
+            component->tick_type = type;
+            if (!instance_ || !instance_->component_locations_.contains(component.get())) return;
+
+            instance_->RemoveFromTickList(component.get());
+            instance_->AddToTickList(component);
+        }
+
+        // Ticks every component of the group, components of one dynamic type together.
+        // Types declaring non conflicting TickAccess run side by side on WorkerPool.
+        // Components removed during the group may cause one other component to be skipped this frame.
+        static void TickGroup(TickType group, float dt)
+        {
+            if (group == TickType::None) return;
+
+            auto& inst = GetInstance();
+            if (!TickSchedulerSettings::ParallelTicks)
+            {
+                for (size_t l = 0; l < inst.tick_lists_[group].size(); ++l)
+                    inst.RunTickList(group, l, dt);
+                return;
+            }
+
+            // types first seen during this group tick from next frame
+            const TickPlan& plan = inst.PlanTicks(group);
+            for (const auto& wave : plan.waves)
+            {
+                for (uint32_t l : wave.main_thread)
+                    inst.RunTickList(group, l, dt);
+
+                WorkerPool::GetInstance().ParallelFor(wave.workers.size(), 1, [&](size_t begin, size_t end)
+                {
+                    for (size_t w = begin; w < end; ++w)
+                        inst.RunTickList(group, wave.workers[w], dt);
+                });
+            }
         }
 
+        // room for objects about to be registered in bulk, components count towards both
+        static void ReserveRegistrations(size_t objects, size_t components)
+        {
+            auto& inst = GetInstance();
+            inst.uuid_to_any_.Reserve(inst.uuid_to_any_.Size() + objects);
+            inst.component_locations_.reserve(inst.component_locations_.size() + components);
+        }
+
+        // component already waiting for BeginPlay is skipped, Init in Play state and GameObject::BeginPlay may both queue it
         static void AddComponentToBeginPlayQueue(std::shared_ptr<IComponent> component)
         {
-            GetInstance().comp_begin_play_queue_.push(component);
+            if (component->begin_play_pending) return;
+            component->begin_play_pending = true;
+
+            auto& inst = GetInstance();
+            inst.comp_begin_play_queue_.Push(component, component->GetInitPriority());
+            ++inst.init_progress_.total;
         }
 
+        // called from ~Component, dynamic type is already lost there, so location is looked up by address
         static void RemoveComponent(IComponent* component)
         {
-            // ����� �������� ������ � ��� ������, ���� ����� ��������� ����� ��������� ������������ � ������� ���� ������ ���������.
-            // �� �������� ��������� ��� ������ ����� � �����.
+            if (!instance_) return;
+            auto& inst = *instance_;
+            inst.RemoveFromTickList(component);
 
-            /*
-            std::type_index typeIndex(typeid(*component));
-            auto it = GetInstance().type_to_components_.find(typeIndex);
-            if (it != GetInstance().type_to_components_.end())
+            auto it = inst.component_locations_.find(component);
+            if (it == inst.component_locations_.end()) return;
+
+            const auto [bucket_index, index] = it->second;
+            inst.component_locations_.erase(it);
+
+            auto& bucket = inst.component_buckets_[bucket_index];
+            const uint32_t last = static_cast<uint32_t>(bucket.raw.size() - 1);
+            if (index != last)
             {
-                auto& vec = it->second;
-                auto where = std::find_if(vec.begin(), vec.end(), [component](std::weak_ptr<IComponent> c)
+                bucket.components[index] = std::move(bucket.components[last]);
+                bucket.raw[index] = bucket.raw[last];
+                inst.component_locations_[bucket.raw[index]].second = index;
+            }
+            bucket.components.pop_back();
+            bucket.raw.pop_back();
+        }
+
+        // Calls fn(std::shared_ptr<T>) for every live component of type T or derived from it.
+        // Components of T removed by fn may cause one other component to be skipped.
+        template <typename T, typename Fn>
+        static void ForEachComponentOfType(Fn&& fn)
+        {
+            static_assert(std::is_base_of<IComponent, T>::value, "T must be derived from Component");
+
+            auto& inst = GetInstance();
+            inst.MatchingBuckets<T>();
+            const uint32_t type_id = ComponentTypeId<T>();
+            // containers are re-indexed every step, fn may register new components
+            for (size_t m = 0; m < inst.type_queries_[type_id].matching.size(); ++m)
+            {
+                const MatchingBucket matching = inst.type_queries_[type_id].matching[m];
+                for (size_t i = 0; i < inst.component_buckets_[matching.bucket].components.size(); ++i)
                 {
-                    if (auto l_c = c.lock())
-                    {
-                        return l_c.get() == component;
-                    }
-                    else
+                    auto component = inst.component_buckets_[matching.bucket].components[i].lock();
+                    if (!component) continue;
+
+                    if constexpr (requires { static_cast<T*>(std::declval<IComponent*>()); })
                     {
-                        throw std::runtime_error("Failed to RemoveComponent, weak ref expired");
+                        if (matching.exact)
+                        {
+                            fn(std::static_pointer_cast<T>(std::move(component)));
+                            continue;
+                        }
                     }
-                });
-                vec.erase(where);
+                    fn(std::dynamic_pointer_cast<T>(std::move(component)));
+                }
             }
-            */
         }
 
         template <typename T>
@@ -124,17 +236,88 @@ namespace GiiGa
             static_assert(std::is_base_of<IComponent, T>::value, "T must be derived from Component");
 
             std::vector<std::weak_ptr<T>> result;
+            ForEachComponentOfType<T>([&result](const std::shared_ptr<T>& component)
+            {
+                result.push_back(component);
+            });
 
-            for (const auto& [uuid, some] : GetInstance().uuid_to_any_)
+            return result;
+        }
+
+        // without world object is taken apart at once
+        static void DeferDestroy(std::shared_ptr<IGameObject> game_object)
+        {
+            if (!instance_)
+                return game_object->DestroyImmediate();
+            instance_->destroyed_game_objects_.push_back(std::move(game_object));
+        }
+
+        static void DeferDestroy(std::shared_ptr<IComponent> component)
+        {
+            if (!instance_)
+                return component->DestroyImmediate();
+            instance_->destroyed_components_.push_back(std::move(component));
+        }
+
+        // Takes apart everything destroyed since last call, objects stay alive until ReleaseDestroyed.
+        // Objects destroyed from here wait for next call.
+        static void DetachDestroyed()
+        {
+            if (!instance_) return;
+            auto& inst = *instance_;
+
+            auto components = std::move(inst.destroyed_components_);
+            auto game_objects = std::move(inst.destroyed_game_objects_);
+            inst.destroyed_components_.clear();
+            inst.destroyed_game_objects_.clear();
+
+            for (auto& component : components)
             {
-                if (auto castedComponent = std::dynamic_pointer_cast<T>(std::static_pointer_cast<IComponent>(some.lock())))
-                {
-                    result.push_back(castedComponent);
-                }
+                component->DestroyImmediate();
+                inst.release_queue_.push_back(std::move(component));
+            }
+            for (auto& game_object : game_objects)
+            {
+                game_object->DestroyImmediate();
+                inst.release_queue_.push_back(std::move(game_object));
             }
+        }
 
+        // drops references held since DetachDestroyed, destructors run here, budget_ms <= 0 releases everything
+        static void ReleaseDestroyed(double budget_ms)
+        {
+            if (!instance_) return;
 
-            return result;
+            const auto start = std::chrono::steady_clock::now();
+            while (!instance_->release_queue_.empty())
+            {
+                auto object = std::move(instance_->release_queue_.front());
+                instance_->release_queue_.pop_front();
+                object.reset();
+
+                if (budget_ms > 0 && std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() >= budget_ms)
+                    break;
+            }
+        }
+
+        // Init and BeginPlay calls done and queued since queues were last empty, total grows while objects are spawned
+        // BeginPlay of components still queued when Play ends is dropped
+        static void ClearBeginPlayQueue()
+        {
+            if (!instance_) return;
+            auto& inst = *instance_;
+            while (!inst.comp_begin_play_queue_.Empty())
+            {
+                if (auto component = inst.comp_begin_play_queue_.Pop().lock())
+                    component->begin_play_pending = false;
+                ++inst.init_progress_.done;
+            }
+        }
+
+        static InitProgress GetInitProgress()
+        {
+            if (!instance_) return {};
+            return instance_->init_progress_;
         }
 
         static std::shared_ptr<ILevelRootGameObjects> GetPersistentLevel()
@@ -144,10 +327,229 @@ namespace GiiGa
 
     protected:
         static inline std::shared_ptr<WorldQuery> instance_;
-        //std::unordered_map<std::type_index, std::vector<std::weak_ptr<IComponent>>> type_to_components_;
-        std::unordered_map<Uuid, std::weak_ptr<void>> uuid_to_any_;
-        std::queue<std::weak_ptr<IComponent>> comp_init_queue_;
-        std::queue<std::weak_ptr<IComponent>> comp_begin_play_queue_;
+
+        enum class RegisteredKind : uint8_t
+        {
+            Other,
+            Component,
+            GameObject,
+        };
+
+        struct RegisteredObject
+        {
+            // points to IComponent or IGameObject subobject for those kinds
+            std::weak_ptr<void> value;
+            RegisteredKind kind = RegisteredKind::Other;
+        };
+
+        template <typename T, typename Base>
+        static std::shared_ptr<T> CastFromBase(std::shared_ptr<Base> base)
+        {
+            if constexpr (std::is_same_v<T, Base>)
+                return base;
+            else if constexpr (requires { static_cast<T*>(std::declval<Base*>()); })
+                return std::static_pointer_cast<T>(std::move(base));
+            else
+                return std::dynamic_pointer_cast<T>(std::move(base));
+        }
+
+        // dense components of one dynamic type, raw mirrors components for lookup on removal
+        struct ComponentBucket
+        {
+            std::type_index type;
+            std::vector<std::weak_ptr<IComponent>> components;
+            std::vector<IComponent*> raw;
+        };
+
+        struct MatchingBucket
+        {
+            uint32_t bucket;
+            // bucket type is T itself, no cast needed
+            bool exact;
+        };
+
+        // buckets of every registered type matching T, extended lazily when new buckets appear
+        struct TypeQuery
+        {
+            size_t checked_buckets = 0;
+            std::vector<MatchingBucket> matching;
+            // buckets that were empty when checked, nothing to test the type against yet
+            std::vector<uint32_t> pending;
+        };
+
+        std::vector<ComponentBucket> component_buckets_;
+        std::unordered_map<std::type_index, uint32_t> bucket_of_type_;
+        // component -> {bucket, index inside bucket}
+        std::unordered_map<const IComponent*, std::pair<uint32_t, uint32_t>> component_locations_;
+        // indexed by ComponentTypeId<T>
+        std::vector<TypeQuery> type_queries_;
+        static inline uint32_t next_component_type_id_ = 0;
+
+        static constexpr size_t TickGroupCount = TickType::PreRender + 1;
+
+        // ticking components of one dynamic type inside one group
+        struct TickList
+        {
+            std::type_index type;
+            TickAccess access;
+            std::vector<std::weak_ptr<IComponent>> components;
+            std::vector<IComponent*> raw;
+        };
+
+        struct TickLocation
+        {
+            TickType group;
+            uint32_t list;
+            uint32_t index;
+        };
+
+        // tick lists of a wave do not conflict, main thread lane runs before workers take the rest
+        struct TickWave
+        {
+            std::vector<uint32_t> main_thread;
+            std::vector<uint32_t> workers;
+        };
+
+        struct TickPlan
+        {
+            size_t planned_lists = 0;
+            std::vector<TickWave> waves;
+        };
+
+        std::array<std::vector<TickList>, TickGroupCount> tick_lists_;
+        std::array<TickPlan, TickGroupCount> tick_plans_;
+        std::array<std::unordered_map<std::type_index, uint32_t>, TickGroupCount> tick_list_of_type_;
+        std::unordered_map<const IComponent*, TickLocation> tick_locations_;
+
+        UuidFlatMap<RegisteredObject> uuid_to_any_;
+        InitQueue comp_init_queue_;
+        InitQueue comp_begin_play_queue_;
+        InitProgress init_progress_;
+
+        std::vector<std::shared_ptr<IGameObject>> destroyed_game_objects_;
+        std::vector<std::shared_ptr<IComponent>> destroyed_components_;
+        std::deque<std::shared_ptr<void>> release_queue_;
+
+        template <typename T>
+        static uint32_t ComponentTypeId()
+        {
+            static const uint32_t id = next_component_type_id_++;
+            return id;
+        }
+
+        void AddToTypeBucket(const std::shared_ptr<IComponent>& component)
+        {
+            if (!component || component_locations_.contains(component.get())) return;
+
+            const std::type_index type(typeid(*component));
+            auto [it, inserted] = bucket_of_type_.try_emplace(type, static_cast<uint32_t>(component_buckets_.size()));
+            if (inserted)
+                component_buckets_.push_back(ComponentBucket{type, {}, {}});
+
+            auto& bucket = component_buckets_[it->second];
+            component_locations_.emplace(component.get(), std::pair{it->second, static_cast<uint32_t>(bucket.raw.size())});
+            bucket.components.push_back(component);
+            bucket.raw.push_back(component.get());
+        }
+
+        void AddToTickList(const std::shared_ptr<IComponent>& component)
+        {
+            if (!component || component->tick_type == TickType::None || tick_locations_.contains(component.get())) return;
+
+            const TickType group = component->tick_type;
+            const std::type_index type(typeid(*component));
+            auto [it, inserted] = tick_list_of_type_[group].try_emplace(type, static_cast<uint32_t>(tick_lists_[group].size()));
+            if (inserted)
+                tick_lists_[group].push_back(TickList{type, component->GetTickAccess(), {}, {}});
+
+            auto& list = tick_lists_[group][it->second];
+            tick_locations_.emplace(component.get(), TickLocation{group, it->second, static_cast<uint32_t>(list.raw.size())});
+            list.components.push_back(component);
+            list.raw.push_back(component.get());
+        }
+
+        void RemoveFromTickList(const IComponent* component)
+        {
+            auto it = tick_locations_.find(component);
+            if (it == tick_locations_.end()) return;
+
+            const TickLocation location = it->second;
+            tick_locations_.erase(it);
+
+            auto& list = tick_lists_[location.group][location.list];
+            const uint32_t last = static_cast<uint32_t>(list.raw.size() - 1);
+            if (location.index != last)
+            {
+                list.components[location.index] = std::move(list.components[last]);
+                list.raw[location.index] = list.raw[last];
+                tick_locations_[list.raw[location.index]].index = location.index;
+            }
+            list.components.pop_back();
+            list.raw.pop_back();
+        }
+
+        // containers are re-indexed every step, main thread ticks may register or remove components
+        void RunTickList(TickType group, size_t list, float dt)
+        {
+            for (size_t i = 0; i < tick_lists_[group][list].components.size(); ++i)
+            {
+                const auto component = tick_lists_[group][list].components[i].lock();
+                if (component && component->IsTickEnabled())
+                    component->Tick(dt);
+            }
+        }
+
+        // every list goes one wave after the last earlier list it conflicts with, so conflicting types keep registration order
+        const TickPlan& PlanTicks(TickType group)
+        {
+            auto& plan = tick_plans_[group];
+            const auto& lists = tick_lists_[group];
+            if (plan.planned_lists == lists.size()) return plan;
+
+            plan.waves.clear();
+            std::vector<size_t> wave_of(lists.size());
+            for (size_t l = 0; l < lists.size(); ++l)
+            {
+                size_t wave = 0;
+                for (size_t p = 0; p < l; ++p)
+                {
+                    if (TickAccess::Conflict(lists[p].access, lists[p].type, lists[l].access, lists[l].type))
+                        wave = std::max(wave, wave_of[p] + 1);
+                }
+                wave_of[l] = wave;
+
+                if (plan.waves.size() <= wave)
+                    plan.waves.resize(wave + 1);
+                auto& lane = lists[l].access.main_thread ? plan.waves[wave].main_thread : plan.waves[wave].workers;
+                lane.push_back(static_cast<uint32_t>(l));
+            }
+            plan.planned_lists = lists.size();
+            return plan;
+        }
+
+        template <typename T>
+        const std::vector<MatchingBucket>& MatchingBuckets()
+        {
+            const uint32_t id = ComponentTypeId<T>();
+            if (type_queries_.size() <= id)
+                type_queries_.resize(id + 1);
+            auto& query = type_queries_[id];
+
+            for (size_t b = query.checked_buckets; b < component_buckets_.size(); ++b)
+                query.pending.push_back(static_cast<uint32_t>(b));
+            query.checked_buckets = component_buckets_.size();
+
+            std::erase_if(query.pending, [&](uint32_t b)
+            {
+                const auto& bucket = component_buckets_[b];
+                if (bucket.raw.empty()) return false;
+                if (dynamic_cast<T*>(bucket.raw.front()))
+                    query.matching.push_back(MatchingBucket{b, bucket.type == std::type_index(typeid(T))});
+                return true;
+            });
+
+            return query.matching;
+        }
 
         virtual std::shared_ptr<ILevelRootGameObjects> GetPersistentLevel_Impl()
         {
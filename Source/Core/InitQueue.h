@@ -0,0 +1,114 @@
+#pragma once
+#include<algorithm>
+#include<array>
+#include<cstddef>
+#include<cstdint>
+#include<deque>
+#include<memory>
+#include<utility>
+#include<vector>
+
+namespace GiiGa
+{
+    struct IComponent;
+
+    struct InitQueueSettings
+    {
+        // time for Init and BeginPlay of queued components per frame, at least one component runs every frame,
+        // 0 runs whole queues every frame
+        static inline double BudgetMs = 4.0;
+    };
+
+    // queued components run in this order, NearCamera ones closest to camera first
+    enum class InitPriority : uint8_t
+    {
+        Camera,
+        Transform,
+        NearCamera,
+        Default
+    };
+
+    // components run from init and begin play queues since they were last empty, for loading screens
+    struct InitProgress
+    {
+        size_t done = 0;
+        size_t total = 0;
+
+        bool Finished() const
+        {
+            return done >= total;
+        }
+
+        float Fraction() const
+        {
+            return total == 0 ? 1.0f : static_cast<float>(done) / static_cast<float>(total);
+        }
+    };
+
+    // FIFO per priority, pops from highest priority first
+    class InitQueue
+    {
+    public:
+        static constexpr size_t PriorityCount = static_cast<size_t>(InitPriority::Default) + 1;
+
+        void Push(std::weak_ptr<IComponent> component, InitPriority priority)
+        {
+            bands_[static_cast<size_t>(priority)].push_back(std::move(component));
+            if (priority == InitPriority::NearCamera)
+                near_camera_sorted_ = false;
+            ++size_;
+        }
+
+        bool Empty() const
+        {
+            return size_ == 0;
+        }
+
+        size_t Size() const
+        {
+            return size_;
+        }
+
+        std::weak_ptr<IComponent> Pop()
+        {
+            for (auto& band : bands_)
+            {
+                if (band.empty()) continue;
+                auto component = std::move(band.front());
+                band.pop_front();
+                --size_;
+                return component;
+            }
+            return {};
+        }
+
+        // Orders NearCamera entries by key(const std::weak_ptr<IComponent>&) ascending, only after new ones were pushed.
+        // Keys are evaluated once per entry.
+        template <typename KeyFn>
+        void SortNearCamera(KeyFn&& key)
+        {
+            if (near_camera_sorted_) return;
+            near_camera_sorted_ = true;
+
+            auto& band = bands_[static_cast<size_t>(InitPriority::NearCamera)];
+            if (band.size() < 2) return;
+
+            sort_scratch_.clear();
+            sort_scratch_.reserve(band.size());
+            for (auto& component : band)
+                sort_scratch_.emplace_back(key(component), std::move(component));
+            std::stable_sort(sort_scratch_.begin(), sort_scratch_.end(), [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+
+            band.clear();
+            for (auto& [_, component] : sort_scratch_)
+                band.push_back(std::move(component));
+            sort_scratch_.clear();
+        }
+
+    private:
+        std::array<std::deque<std::weak_ptr<IComponent>>, PriorityCount> bands_;
+        size_t size_ = 0;
+        bool near_camera_sorted_ = true;
+        std::vector<std::pair<float, std::weak_ptr<IComponent>>> sort_scratch_;
+    };
+}
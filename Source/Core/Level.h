@@ -66,7 +66,7 @@ namespace GiiGa
             name_ = name;
         }
 
-        bool GetIsActive() const
+        bool GetIsActive() const override
         {
             return isActive_;
         }
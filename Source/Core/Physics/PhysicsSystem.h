@@ -27,6 +27,7 @@
 #include <iostream>
 #include <cstdarg>
 #include <thread>
+#include <cmath>
 #include <ICollision.h>
 
 // Disable common warnings triggered by Jolt, you can use JPH_SUPPRESS_WARNING_PUSH / JPH_SUPPRESS_WARNING_POP to store and restore the warning state
@@ -278,6 +279,11 @@ namespace GiiGa
 
             physics_system.Init(cMaxBodies, cNumBodyMutexes, cMaxBodyPairs, cMaxContactConstraints, broad_phase_layer_interface, object_vs_broadphase_layer_filter, object_vs_object_layer_filter);
 
+            transforms_changed_handle_ = TransformSystem::GetInstance().OnTransformsChanged.Register([this](const std::span<const uint32_t>& ids)
+            {
+                SyncMovedTransforms(ids);
+            });
+
             physics_system.SetBodyActivationListener(&body_activation_listener);
 
             physics_system.SetContactListener(&contact_listener);
@@ -289,44 +295,120 @@ namespace GiiGa
 
             JPH::JobSystemThreadPool job_system(JPH::cMaxPhysicsJobs, JPH::cMaxPhysicsBarriers, thread::hardware_concurrency() - 1);
             auto& instance = GetInstance();
+
+            // bodies falling asleep during the step still need their final pose written
+            instance.pre_step_heights_.clear();
             for (auto [uuid, body] : instance.collision_body_map_)
             {
-                const auto col_comp = WorldQuery::GetWithUUID<ICollision>(uuid);
-                if (!col_comp) continue;
-
-                JPH::RVec3 position = body_interface.GetCenterOfMassPosition(body);
-                JPH::Quat rotation = body_interface.GetRotation(body);
                 if (body_interface.IsActive(body))
-                    col_comp->SetOwnerWorldLocation(JoltVecToVec(position));
-                if (body_interface.IsActive(body))
-                    col_comp->SetOwnerWorldRotation(JoltQuatToQuat(rotation));
+                    instance.pre_step_heights_[body] = body_interface.GetCenterOfMassPosition(body).GetY();
             }
 
             const int cCollisionSteps = 1;
 
             instance.physics_system.Update(dt, cCollisionSteps, instance.temp_allocator, &job_system);
+
+            // poses of this step go to transforms before the frame is rendered, SyncMovedTransforms does not push them back
+            instance.written_poses_.clear();
+            for (auto [uuid, body] : instance.collision_body_map_)
+            {
+                const auto stepped = instance.pre_step_heights_.find(body);
+                if (stepped == instance.pre_step_heights_.end() && !body_interface.IsActive(body)) continue;
+
+                const auto col_comp = WorldQuery::GetWithUUID<ICollision>(uuid);
+                if (!col_comp) continue;
+
+                JPH::RVec3 position = body_interface.GetCenterOfMassPosition(body);
+                JPH::Quat rotation = body_interface.GetRotation(body);
+                col_comp->SetOwnerWorldLocation(JoltVecToVec(position));
+                col_comp->SetOwnerWorldRotation(JoltQuatToQuat(rotation));
+                instance.RecordWrittenPose(uuid);
+
+#ifndef NDEBUG
+                if (stepped != instance.pre_step_heights_.end())
+                    instance.CheckFalling(body, stepped->second, position.GetY());
+#endif
+            }
         }
 
         void BindOnTransformUpdate(const std::shared_ptr<ICollision>& collision_comp)
         {
             if (const auto& owner_trans = std::dynamic_pointer_cast<GameObject>(collision_comp->GetOwner())->GetTransformComponent().lock())
             {
-                update_transform_cashed_.emplace(collision_comp->GetUuid(),
-                                                 owner_trans->OnUpdateTransform.Register([this](const std::shared_ptr<TransformComponent>& trans)
-                                                 {
-                                                     if (const auto& owner = std::dynamic_pointer_cast<GameObject>(trans->GetOwner()))
-                                                     {
-                                                         const auto& col_comp = owner->GetComponent<ICollision>();
-                                                         const auto& bodyID = GetInstance().collision_body_map_.at(col_comp->GetUuid());
-                                                         GetBodyInterface().SetPositionAndRotation(bodyID,
-                                                                                                   VecToJoltVec(trans->GetWorldLocation()),
-                                                                                                   QuatToJoltQuat(trans->GetWorldQuatRotation()),
-                                                                                                   JPH::EActivation::Activate);
-                                                     }
-                                                 }));
+                const uint32_t transform_id = owner_trans->GetTransformId();
+                transform_body_map_[transform_id] = collision_body_map_.at(collision_comp->GetUuid());
+                collision_transform_map_[collision_comp->GetUuid()] = transform_id;
+            }
+        }
+
+        // moves bodies whose owner transforms changed since the previous TransformSystem::Update,
+        // transforms still holding the pose Simulate wrote from their own body are skipped
+        void SyncMovedTransforms(std::span<const uint32_t> ids)
+        {
+            if (transform_body_map_.empty())
+            {
+                written_poses_.clear();
+                return;
+            }
+
+            auto& transforms = TransformSystem::GetInstance();
+            moved_transforms_.clear();
+            moved_bodies_.clear();
+            for (const uint32_t id : ids)
+            {
+                auto it = transform_body_map_.find(id);
+                if (it == transform_body_map_.end() || !transforms.IsAlive(id)) continue;
+                if (IsWrittenPose(id)) continue;
+                moved_transforms_.push_back(id);
+                moved_bodies_.push_back(it->second);
+            }
+            written_poses_.clear();
+            if (moved_transforms_.empty()) return;
+
+            moved_locations_.resize(moved_transforms_.size());
+            moved_rotations_.resize(moved_transforms_.size());
+            TransformSystem::GetInstance().GetWorldPoses(moved_transforms_, moved_locations_, moved_rotations_);
+
+            auto& body_interface = GetBodyInterface();
+            for (size_t i = 0; i < moved_bodies_.size(); ++i)
+            {
+                body_interface.SetPositionAndRotation(moved_bodies_[i],
+                                                      VecToJoltVec(moved_locations_[i]),
+                                                      QuatToJoltQuat(moved_rotations_[i]),
+                                                      JPH::EActivation::Activate);
             }
         }
 
+        void RecordWrittenPose(const Uuid& collision_uuid)
+        {
+            const auto it = collision_transform_map_.find(collision_uuid);
+            if (it == collision_transform_map_.end()) return;
+
+            auto& transforms = TransformSystem::GetInstance();
+            written_poses_[it->second] = {transforms.GetWorldLocation(it->second), transforms.GetWorldRotation(it->second)};
+        }
+
+        // a body still falling after the step has to be lower than before it,
+        // otherwise something keeps resetting its pose (e.g. transforms echoed back into Jolt)
+        void CheckFalling(JPH::BodyID body, float pre_step_height, float height)
+        {
+            if (GetBodyInterface().GetLinearVelocity(body).GetY() >= -FallingSpeedToCheck) return;
+            if (height < pre_step_height) return;
+            el::Loggers::getLogger(LogPhysics)->warn("Falling body %v did not get lower during the step: %v -> %v",
+                                                     body.GetIndexAndSequenceNumber(), pre_step_height, height);
+        }
+
+        bool IsWrittenPose(uint32_t transform_id)
+        {
+            const auto it = written_poses_.find(transform_id);
+            if (it == written_poses_.end()) return false;
+
+            // anything else moving the transform after Simulate (script, parent) changes the pose
+            auto& transforms = TransformSystem::GetInstance();
+            return Vector3::DistanceSquared(transforms.GetWorldLocation(transform_id), it->second.first) <= WrittenPoseEpsilon
+                && std::abs(transforms.GetWorldRotation(transform_id).Dot(it->second.second)) >= 1.0f - WrittenPoseEpsilon;
+        }
+
         static JPH::BodyID RegisterCollision(const std::shared_ptr<ICollision>& collision_comp)
         {
             auto& body_interface = GetInstance().physics_system.GetBodyInterface();
@@ -406,7 +488,11 @@ namespace GiiGa
             if (GetInstance().collision_body_map_.contains(collision_comp->GetUuid()))
             {
                 GetInstance().DestroyBody(GetInstance().collision_body_map_.at(collision_comp->GetUuid()));
-                GetInstance().update_transform_cashed_.erase(collision_comp->GetUuid());
+                if (auto it = GetInstance().collision_transform_map_.find(collision_comp->GetUuid()); it != GetInstance().collision_transform_map_.end())
+                {
+                    GetInstance().transform_body_map_.erase(it->second);
+                    GetInstance().collision_transform_map_.erase(it);
+                }
                 GetInstance().body_collision_map_.erase(GetInstance().collision_body_map_.at(collision_comp->GetUuid()));
                 GetInstance().collision_body_map_.erase(collision_comp->GetUuid());
             }
@@ -454,20 +540,43 @@ namespace GiiGa
             GetInstance().FreshObjects();
         }
 
-        void DestroyBody(const JPH::BodyID& bodyID) const
+        void DestroyBody(const JPH::BodyID& bodyID)
         {
+            if (removal_batch_depth_ > 0)
+            {
+                removed_bodies_.push_back(bodyID);
+                return;
+            }
             GetBodyInterface().RemoveBody(bodyID);
             GetBodyInterface().DeactivateBody(bodyID);
         }
 
+        // bodies destroyed until matching End go to Jolt in one call
+        static void BeginBodyRemovalBatch()
+        {
+            ++GetInstance().removal_batch_depth_;
+        }
+
+        static void EndBodyRemovalBatch()
+        {
+            auto& instance = GetInstance();
+            if (--instance.removal_batch_depth_ > 0 || instance.removed_bodies_.empty()) return;
+
+            const int count = static_cast<int>(instance.removed_bodies_.size());
+            GetBodyInterface().RemoveBodies(instance.removed_bodies_.data(), count);
+            GetBodyInterface().DeactivateBodies(instance.removed_bodies_.data(), count);
+            instance.removed_bodies_.clear();
+        }
+
         void FreshObjects()
         {
             for (auto [uuid, body] : collision_body_map_)
             {
                 DestroyBody(body);
-                WorldQuery::GetWithUUID<ICollision>(uuid)->OnUpdateTransform.Unregister(update_transform_cashed_.at(uuid));
             }
-            update_transform_cashed_.clear();
+            transform_body_map_.clear();
+            collision_transform_map_.clear();
+            written_poses_.clear();
             collision_body_map_.clear();
             body_collision_map_.clear();
         }
@@ -481,6 +590,7 @@ namespace GiiGa
         void Destroy()
         {
             FreshObjects();
+            TransformSystem::GetInstance().OnTransformsChanged.Unregister(transforms_changed_handle_);
 
             JPH::UnregisterTypes();
 
@@ -497,7 +607,26 @@ namespace GiiGa
         std::unordered_map<Uuid, JPH::BodyID> collision_body_map_;
         std::unordered_map<JPH::BodyID, Uuid> body_collision_map_;
 
-        std::unordered_map<Uuid, EventHandle<std::shared_ptr<TransformComponent>>> update_transform_cashed_;
+        // owner transform id -> body, batched sync on TransformSystem::OnTransformsChanged
+        std::unordered_map<uint32_t, JPH::BodyID> transform_body_map_;
+        std::unordered_map<Uuid, uint32_t> collision_transform_map_;
+        EventHandle<std::span<const uint32_t>> transforms_changed_handle_ = EventHandle<std::span<const uint32_t>>::Null();
+
+        std::vector<uint32_t> moved_transforms_;
+        std::vector<JPH::BodyID> moved_bodies_;
+        std::vector<Vector3> moved_locations_;
+        std::vector<Quaternion> moved_rotations_;
+
+        // owner transform id -> world pose Simulate wrote from the body, not pushed back into Jolt
+        static constexpr float WrittenPoseEpsilon = 1e-6f;
+        std::unordered_map<uint32_t, std::pair<Vector3, Quaternion>> written_poses_;
+
+        // bodies active before the step -> center of mass height, for CheckFalling
+        static constexpr float FallingSpeedToCheck = 0.1f;
+        std::unordered_map<JPH::BodyID, float> pre_step_heights_;
+
+        uint32_t removal_batch_depth_ = 0;
+        std::vector<JPH::BodyID> removed_bodies_;
 
         JPH::PhysicsSystem physics_system;
         BPLayerInterfaceImpl broad_phase_layer_interface;
@@ -217,7 +217,9 @@ PYBIND11_EMBEDDED_MODULE(GiiGaPy, m)
         })
         .def("OnBeginOverlap", &GiiGa::Component::OnBeginOverlap, "arg0: CollisionComponent, arg1: CollideInfo")
         .def("OnOverlapping", &GiiGa::Component::OnOverlapping, "arg0: CollisionComponent, arg1: CollideInfo")
-        .def("OnEndOverlap", &GiiGa::Component::OnEndOverlap, "arg0: CollisionComponent");
+        .def("OnEndOverlap", &GiiGa::Component::OnEndOverlap, "arg0: CollisionComponent")
+        .def("OnPoolRelease", &GiiGa::Component::OnPoolRelease, "Called when owner goes back to pool, reset state here")
+        .def("OnPoolAcquire", &GiiGa::Component::OnPoolAcquire, "Called when owner is taken from pool again");
 
     pybind11::class_<GiiGa::TransformComponent, std::shared_ptr<GiiGa::TransformComponent>, GiiGa::Component>(m, "TransformComponent")
         .def(pybind11::init<>())
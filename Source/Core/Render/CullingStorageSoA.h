@@ -0,0 +1,391 @@
+#pragma once
+
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include<directxtk12/SimpleMath.h>
+#include<Octree/octree.h>
+#include<immintrin.h>
+
+#include<vector>
+#include<algorithm>
+
+namespace GiiGa
+{
+    /*
+     * Registered AABBs kept as structure-of-arrays for brute-force frustum test.
+     * Slots are dense and addressed by position: owner keeps them in step with its own
+     * packed arrays, RemoveAt swaps last slot into removed one exactly like owner does.
+     */
+    class CullingStorageSoA
+    {
+    public:
+#if defined(__AVX__) || defined(__AVX2__)
+        static constexpr size_t BatchSize = 8;
+#else
+        static constexpr size_t BatchSize = 4;
+#endif
+
+        void Add(OrthoTree::index_t ent_id, const OrthoTree::BoundingBox3D& box)
+        {
+            ids_.push_back(ent_id);
+            min_x_.push_back(static_cast<float>(box.Min[0]));
+            min_y_.push_back(static_cast<float>(box.Min[1]));
+            min_z_.push_back(static_cast<float>(box.Min[2]));
+            max_x_.push_back(static_cast<float>(box.Max[0]));
+            max_y_.push_back(static_cast<float>(box.Max[1]));
+            max_z_.push_back(static_cast<float>(box.Max[2]));
+        }
+
+        void RemoveAt(size_t slot)
+        {
+            const size_t last = ids_.size() - 1;
+
+            if (slot != last)
+            {
+                ids_[slot] = ids_[last];
+                min_x_[slot] = min_x_[last];
+                min_y_[slot] = min_y_[last];
+                min_z_[slot] = min_z_[last];
+                max_x_[slot] = max_x_[last];
+                max_y_[slot] = max_y_[last];
+                max_z_[slot] = max_z_[last];
+            }
+
+            ids_.pop_back();
+            min_x_.pop_back();
+            min_y_.pop_back();
+            min_z_.pop_back();
+            max_x_.pop_back();
+            max_y_.pop_back();
+            max_z_.pop_back();
+        }
+
+        void SetAt(size_t slot, const OrthoTree::BoundingBox3D& box)
+        {
+            min_x_[slot] = static_cast<float>(box.Min[0]);
+            min_y_[slot] = static_cast<float>(box.Min[1]);
+            min_z_[slot] = static_cast<float>(box.Min[2]);
+            max_x_[slot] = static_cast<float>(box.Max[0]);
+            max_y_[slot] = static_cast<float>(box.Max[1]);
+            max_z_[slot] = static_cast<float>(box.Max[2]);
+        }
+
+        size_t Size() const
+        {
+            return ids_.size();
+        }
+
+        const std::vector<OrthoTree::index_t>& Ids() const
+        {
+            return ids_;
+        }
+
+        // Planes as returned by ExtractFrustumPlanesPointInside:
+        // point is inside when dot(normal, point) >= w, same convention OctreeBoxMap::FrustumCulling uses.
+        void FrustumCulling(const std::vector<DirectX::SimpleMath::Plane>& planes, float tolerance, std::vector<OrthoTree::index_t>& result) const
+        {
+            const size_t count = ids_.size();
+            const size_t batched = count - count % BatchSize;
+
+            for (size_t i = 0; i < batched; i += BatchSize)
+            {
+                uint32_t visible_bits = TestBatch(planes, tolerance, i);
+                while (visible_bits)
+                {
+                    const unsigned long lane = CountTrailingZeros(visible_bits);
+                    result.push_back(ids_[i + lane]);
+                    visible_bits &= visible_bits - 1;
+                }
+            }
+
+            for (size_t i = batched; i < count; ++i)
+            {
+                if (TestOne(planes, tolerance, i))
+                    result.push_back(ids_[i]);
+            }
+        }
+
+        // Tests one slot, same plane convention as FrustumCulling.
+        bool TestSlot(const std::vector<DirectX::SimpleMath::Plane>& planes, float tolerance, size_t slot) const
+        {
+            return TestOne(planes, tolerance, slot);
+        }
+
+        // One sweep for several frusta: for every entry visible in at least one view
+        // pushes its id and bit mask of views (bit i - views_planes[i]) it is visible in.
+        void MultiFrustumCulling(const std::vector<std::vector<DirectX::SimpleMath::Plane>>& views_planes, float tolerance,
+                                 std::vector<OrthoTree::index_t>& result_ids, std::vector<uint64_t>& result_masks) const
+        {
+            const size_t count = ids_.size();
+            const size_t batched = count - count % BatchSize;
+
+            for (size_t i = 0; i < batched; i += BatchSize)
+            {
+                uint64_t lane_masks[BatchSize] = {};
+                uint32_t any_visible = 0;
+
+                for (size_t view = 0; view < views_planes.size(); ++view)
+                {
+                    uint32_t visible_bits = TestBatch(views_planes[view], tolerance, i);
+                    any_visible |= visible_bits;
+                    while (visible_bits)
+                    {
+                        const unsigned long lane = CountTrailingZeros(visible_bits);
+                        lane_masks[lane] |= uint64_t{1} << view;
+                        visible_bits &= visible_bits - 1;
+                    }
+                }
+
+                while (any_visible)
+                {
+                    const unsigned long lane = CountTrailingZeros(any_visible);
+                    result_ids.push_back(ids_[i + lane]);
+                    result_masks.push_back(lane_masks[lane]);
+                    any_visible &= any_visible - 1;
+                }
+            }
+
+            for (size_t i = batched; i < count; ++i)
+            {
+                uint64_t mask = 0;
+                for (size_t view = 0; view < views_planes.size(); ++view)
+                {
+                    if (TestOne(views_planes[view], tolerance, i))
+                        mask |= uint64_t{1} << view;
+                }
+
+                if (mask)
+                {
+                    result_ids.push_back(ids_[i]);
+                    result_masks.push_back(mask);
+                }
+            }
+        }
+
+        // Spatial queries below are SSE 4-wide and call fn for every matching slot, they never allocate.
+
+        // fn(slot) for every box intersecting [min, max].
+        template <typename Fn>
+        void ForEachOverlapBox(const DirectX::SimpleMath::Vector3& min, const DirectX::SimpleMath::Vector3& max, Fn&& fn) const
+        {
+            const size_t count = ids_.size();
+            const size_t batched = count - count % 4;
+            const __m128 qmin_x = _mm_set1_ps(min.x), qmin_y = _mm_set1_ps(min.y), qmin_z = _mm_set1_ps(min.z);
+            const __m128 qmax_x = _mm_set1_ps(max.x), qmax_y = _mm_set1_ps(max.y), qmax_z = _mm_set1_ps(max.z);
+
+            for (size_t i = 0; i < batched; i += 4)
+            {
+                __m128 overlap = _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(min_x_.data() + i), qmax_x), _mm_cmpge_ps(_mm_loadu_ps(max_x_.data() + i), qmin_x));
+                overlap = _mm_and_ps(overlap, _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(min_y_.data() + i), qmax_y), _mm_cmpge_ps(_mm_loadu_ps(max_y_.data() + i), qmin_y)));
+                overlap = _mm_and_ps(overlap, _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(min_z_.data() + i), qmax_z), _mm_cmpge_ps(_mm_loadu_ps(max_z_.data() + i), qmin_z)));
+
+                uint32_t bits = static_cast<uint32_t>(_mm_movemask_ps(overlap));
+                while (bits)
+                {
+                    fn(i + CountTrailingZeros(bits));
+                    bits &= bits - 1;
+                }
+            }
+
+            for (size_t i = batched; i < count; ++i)
+            {
+                if (min_x_[i] <= max.x && max_x_[i] >= min.x && min_y_[i] <= max.y && max_y_[i] >= min.y && min_z_[i] <= max.z && max_z_[i] >= min.z)
+                    fn(i);
+            }
+        }
+
+        // fn(slot, squared distance from point to box), 0 for points inside box. Every slot is visited.
+        template <typename Fn>
+        void ForEachDistanceSq(const DirectX::SimpleMath::Vector3& point, Fn&& fn) const
+        {
+            const size_t count = ids_.size();
+            const size_t batched = count - count % 4;
+            const __m128 px = _mm_set1_ps(point.x), py = _mm_set1_ps(point.y), pz = _mm_set1_ps(point.z);
+
+            for (size_t i = 0; i < batched; i += 4)
+            {
+                alignas(16) float dist_sq[4];
+                _mm_store_ps(dist_sq, DistanceSqBatch(px, py, pz, i));
+                for (size_t lane = 0; lane < 4; ++lane)
+                    fn(i + lane, dist_sq[lane]);
+            }
+
+            for (size_t i = batched; i < count; ++i)
+                fn(i, DistanceSqOne(point, i));
+        }
+
+        // fn(slot) for every box intersecting sphere.
+        template <typename Fn>
+        void ForEachOverlapSphere(const DirectX::SimpleMath::Vector3& center, float radius, Fn&& fn) const
+        {
+            const size_t count = ids_.size();
+            const size_t batched = count - count % 4;
+            const __m128 cx = _mm_set1_ps(center.x), cy = _mm_set1_ps(center.y), cz = _mm_set1_ps(center.z);
+            const __m128 radius_sq = _mm_set1_ps(radius * radius);
+
+            for (size_t i = 0; i < batched; i += 4)
+            {
+                uint32_t bits = static_cast<uint32_t>(_mm_movemask_ps(_mm_cmple_ps(DistanceSqBatch(cx, cy, cz, i), radius_sq)));
+                while (bits)
+                {
+                    fn(i + CountTrailingZeros(bits));
+                    bits &= bits - 1;
+                }
+            }
+
+            for (size_t i = batched; i < count; ++i)
+            {
+                if (DistanceSqOne(center, i) <= radius * radius)
+                    fn(i);
+            }
+        }
+
+        // fn(slot, t) for every box ray origin + t * direction enters within [0, max_t], t is 0 when origin is inside.
+        // Slab test, inv_direction is 1 / direction per axis.
+        template <typename Fn>
+        void ForEachRayHit(const DirectX::SimpleMath::Vector3& origin, const DirectX::SimpleMath::Vector3& inv_direction, float max_t, Fn&& fn) const
+        {
+            const size_t count = ids_.size();
+            const size_t batched = count - count % 4;
+            const __m128 ox = _mm_set1_ps(origin.x), oy = _mm_set1_ps(origin.y), oz = _mm_set1_ps(origin.z);
+            const __m128 ix = _mm_set1_ps(inv_direction.x), iy = _mm_set1_ps(inv_direction.y), iz = _mm_set1_ps(inv_direction.z);
+
+            for (size_t i = 0; i < batched; i += 4)
+            {
+                const __m128 t1x = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(min_x_.data() + i), ox), ix);
+                const __m128 t2x = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(max_x_.data() + i), ox), ix);
+                const __m128 t1y = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(min_y_.data() + i), oy), iy);
+                const __m128 t2y = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(max_y_.data() + i), oy), iy);
+                const __m128 t1z = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(min_z_.data() + i), oz), iz);
+                const __m128 t2z = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(max_z_.data() + i), oz), iz);
+
+                __m128 t_enter = _mm_max_ps(_mm_max_ps(_mm_min_ps(t1x, t2x), _mm_min_ps(t1y, t2y)), _mm_min_ps(t1z, t2z));
+                __m128 t_exit = _mm_min_ps(_mm_min_ps(_mm_max_ps(t1x, t2x), _mm_max_ps(t1y, t2y)), _mm_max_ps(t1z, t2z));
+                t_enter = _mm_max_ps(t_enter, _mm_setzero_ps());
+                t_exit = _mm_min_ps(t_exit, _mm_set1_ps(max_t));
+
+                uint32_t bits = static_cast<uint32_t>(_mm_movemask_ps(_mm_cmple_ps(t_enter, t_exit)));
+                if (!bits)
+                    continue;
+
+                alignas(16) float enter[4];
+                _mm_store_ps(enter, t_enter);
+                while (bits)
+                {
+                    const unsigned long lane = CountTrailingZeros(bits);
+                    fn(i + lane, enter[lane]);
+                    bits &= bits - 1;
+                }
+            }
+
+            for (size_t i = batched; i < count; ++i)
+            {
+                const float t1x = (min_x_[i] - origin.x) * inv_direction.x, t2x = (max_x_[i] - origin.x) * inv_direction.x;
+                const float t1y = (min_y_[i] - origin.y) * inv_direction.y, t2y = (max_y_[i] - origin.y) * inv_direction.y;
+                const float t1z = (min_z_[i] - origin.z) * inv_direction.z, t2z = (max_z_[i] - origin.z) * inv_direction.z;
+
+                const float t_enter = std::max({std::min(t1x, t2x), std::min(t1y, t2y), std::min(t1z, t2z), 0.0f});
+                const float t_exit = std::min({std::max(t1x, t2x), std::max(t1y, t2y), std::max(t1z, t2z), max_t});
+                if (t_enter <= t_exit)
+                    fn(i, t_enter);
+            }
+        }
+
+    private:
+        std::vector<float> min_x_, min_y_, min_z_;
+        std::vector<float> max_x_, max_y_, max_z_;
+        std::vector<OrthoTree::index_t> ids_;
+
+        static unsigned long CountTrailingZeros(uint32_t bits)
+        {
+#if defined(_MSC_VER)
+            unsigned long index;
+            _BitScanForward(&index, bits);
+            return index;
+#else
+            return static_cast<unsigned long>(__builtin_ctz(bits));
+#endif
+        }
+
+        // Per plane only the box corner furthest along the normal is tested,
+        // the normal is the same for every lane so the corner is picked per array, not per lane.
+#if defined(__AVX__) || defined(__AVX2__)
+        uint32_t TestBatch(const std::vector<DirectX::SimpleMath::Plane>& planes, float tolerance, size_t first) const
+        {
+            __m256 outside = _mm256_setzero_ps();
+            const __m256 neg_tolerance = _mm256_set1_ps(-tolerance);
+
+            for (const auto& plane : planes)
+            {
+                const __m256 px = _mm256_loadu_ps((plane.x >= 0 ? max_x_ : min_x_).data() + first);
+                const __m256 py = _mm256_loadu_ps((plane.y >= 0 ? max_y_ : min_y_).data() + first);
+                const __m256 pz = _mm256_loadu_ps((plane.z >= 0 ? max_z_ : min_z_).data() + first);
+
+                __m256 dist = _mm256_mul_ps(px, _mm256_set1_ps(plane.x));
+                dist = _mm256_add_ps(dist, _mm256_mul_ps(py, _mm256_set1_ps(plane.y)));
+                dist = _mm256_add_ps(dist, _mm256_mul_ps(pz, _mm256_set1_ps(plane.z)));
+                dist = _mm256_sub_ps(dist, _mm256_set1_ps(plane.w));
+
+                outside = _mm256_or_ps(outside, _mm256_cmp_ps(dist, neg_tolerance, _CMP_LT_OQ));
+            }
+
+            return ~static_cast<uint32_t>(_mm256_movemask_ps(outside)) & 0xFFu;
+        }
+#else
+        uint32_t TestBatch(const std::vector<DirectX::SimpleMath::Plane>& planes, float tolerance, size_t first) const
+        {
+            __m128 outside = _mm_setzero_ps();
+            const __m128 neg_tolerance = _mm_set1_ps(-tolerance);
+
+            for (const auto& plane : planes)
+            {
+                const __m128 px = _mm_loadu_ps((plane.x >= 0 ? max_x_ : min_x_).data() + first);
+                const __m128 py = _mm_loadu_ps((plane.y >= 0 ? max_y_ : min_y_).data() + first);
+                const __m128 pz = _mm_loadu_ps((plane.z >= 0 ? max_z_ : min_z_).data() + first);
+
+                __m128 dist = _mm_mul_ps(px, _mm_set1_ps(plane.x));
+                dist = _mm_add_ps(dist, _mm_mul_ps(py, _mm_set1_ps(plane.y)));
+                dist = _mm_add_ps(dist, _mm_mul_ps(pz, _mm_set1_ps(plane.z)));
+                dist = _mm_sub_ps(dist, _mm_set1_ps(plane.w));
+
+                outside = _mm_or_ps(outside, _mm_cmplt_ps(dist, neg_tolerance));
+            }
+
+            return ~static_cast<uint32_t>(_mm_movemask_ps(outside)) & 0xFu;
+        }
+#endif
+
+        __m128 DistanceSqBatch(__m128 px, __m128 py, __m128 pz, size_t first) const
+        {
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(min_x_.data() + first), px), _mm_sub_ps(px, _mm_loadu_ps(max_x_.data() + first))), zero);
+            const __m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(min_y_.data() + first), py), _mm_sub_ps(py, _mm_loadu_ps(max_y_.data() + first))), zero);
+            const __m128 dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(min_z_.data() + first), pz), _mm_sub_ps(pz, _mm_loadu_ps(max_z_.data() + first))), zero);
+            return _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+        }
+
+        float DistanceSqOne(const DirectX::SimpleMath::Vector3& point, size_t slot) const
+        {
+            const float dx = std::max({min_x_[slot] - point.x, point.x - max_x_[slot], 0.0f});
+            const float dy = std::max({min_y_[slot] - point.y, point.y - max_y_[slot], 0.0f});
+            const float dz = std::max({min_z_[slot] - point.z, point.z - max_z_[slot], 0.0f});
+            return dx * dx + dy * dy + dz * dz;
+        }
+
+        bool TestOne(const std::vector<DirectX::SimpleMath::Plane>& planes, float tolerance, size_t slot) const
+        {
+            for (const auto& plane : planes)
+            {
+                const float px = plane.x >= 0 ? max_x_[slot] : min_x_[slot];
+                const float py = plane.y >= 0 ? max_y_[slot] : min_y_[slot];
+                const float pz = plane.z >= 0 ? max_z_[slot] : min_z_[slot];
+
+                if (plane.x * px + plane.y * py + plane.z * pz - plane.w < -tolerance)
+                    return false;
+            }
+            return true;
+        }
+    };
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+
+#include<array>
+#include<span>
+#include<vector>
+#include<unordered_map>
+#include<algorithm>
+
+#include<ObjectMask.h>
+#include<IRenderable.h>
+#include<IObjectShaderResource.h>
+
+namespace GiiGa
+{
+    struct DrawItem
+    {
+        uint64_t sort_key;
+        ObjectMask object_mask;
+        IRenderable* renderable;
+        IObjectShaderResource* shader_resource;
+        uint8_t lod;
+    };
+
+    /*
+     * Flat list of draw items sorted by 64-bit key:
+     * | object mask (PSO selector) 16 | shader resource id 24 | quantized depth 24 |
+     * so one PSO and one material form contiguous ranges, front to back inside a range.
+     * Storage is kept between frames, Clear does not release memory.
+     */
+    class DrawList
+    {
+    public:
+        static constexpr uint32_t DepthBits = 24;
+        static constexpr uint32_t ShaderResourceBits = 24;
+        static constexpr uint32_t ObjectMaskBits = 16;
+
+        static constexpr uint32_t ShaderResourceOffset = DepthBits;
+        static constexpr uint32_t ObjectMaskOffset = DepthBits + ShaderResourceBits;
+
+        void Clear()
+        {
+            items_.clear();
+            shader_resource_ids_.clear();
+        }
+
+        // depth is normalized [0, 1], values out of range are clamped
+        void Add(IRenderable* renderable, const SortData& sort_data, float depth, uint8_t lod = 0)
+        {
+            const uint64_t mask_bits = sort_data.object_mask.GetMask().to_ullong() & ((uint64_t{1} << ObjectMaskBits) - 1);
+
+            auto [resource_id, _] = shader_resource_ids_.try_emplace(sort_data.shaderResource.get(), static_cast<uint32_t>(shader_resource_ids_.size()));
+            const uint64_t resource_bits = resource_id->second & ((uint64_t{1} << ShaderResourceBits) - 1);
+
+            const float clamped_depth = std::clamp(depth, 0.0f, 1.0f);
+            const uint64_t depth_bits = static_cast<uint64_t>(clamped_depth * static_cast<float>((uint64_t{1} << DepthBits) - 1));
+
+            items_.push_back(DrawItem{
+                .sort_key = (mask_bits << ObjectMaskOffset) | (resource_bits << ShaderResourceOffset) | depth_bits,
+                .object_mask = sort_data.object_mask,
+                .renderable = renderable,
+                .shader_resource = sort_data.shaderResource.get(),
+                .lod = lod
+            });
+        }
+
+        // LSD radix sort by sort_key, byte digits, passes where all items share a digit are skipped
+        void Sort()
+        {
+            scratch_.resize(items_.size());
+
+            for (uint32_t shift = 0; shift < 64; shift += 8)
+            {
+                std::array<size_t, 256> offsets{};
+                for (const auto& item : items_)
+                    ++offsets[(item.sort_key >> shift) & 0xFF];
+
+                if (offsets[(items_.empty() ? 0 : (items_.front().sort_key >> shift) & 0xFF)] == items_.size())
+                    continue;
+
+                size_t sum = 0;
+                for (auto& offset : offsets)
+                {
+                    const size_t count = offset;
+                    offset = sum;
+                    sum += count;
+                }
+
+                for (const auto& item : items_)
+                    scratch_[offsets[(item.sort_key >> shift) & 0xFF]++] = item;
+
+                items_.swap(scratch_);
+            }
+        }
+
+        const std::vector<DrawItem>& Items() const
+        {
+            return items_;
+        }
+
+        // Calls fn(object_mask, items) for every contiguous range of items with same object mask.
+        template <typename Fn>
+        void ForEachMaskRange(Fn&& fn) const
+        {
+            size_t begin = 0;
+            while (begin < items_.size())
+            {
+                size_t end = begin + 1;
+                while (end < items_.size() && items_[end].object_mask == items_[begin].object_mask)
+                    ++end;
+
+                fn(items_[begin].object_mask, std::span<const DrawItem>(items_.data() + begin, end - begin));
+                begin = end;
+            }
+        }
+
+    private:
+        std::vector<DrawItem> items_;
+        std::vector<DrawItem> scratch_;
+        // dense per-frame ids for shader resources, map keeps its buckets between frames
+        std::unordered_map<IObjectShaderResource*, uint32_t> shader_resource_ids_;
+    };
+}
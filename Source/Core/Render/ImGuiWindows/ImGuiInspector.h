@@ -253,6 +253,27 @@ namespace GiiGa
                 ImGui::EndDragDropTarget();
             }
 
+            bool is_static = comp->IsStatic();
+            if (ImGui::Checkbox("Static", &is_static))
+            {
+                comp->SetIsStatic(is_static);
+            }
+
+            bool is_occluder = comp->IsOccluder();
+            if (ImGui::Checkbox("Occluder", &is_occluder))
+            {
+                comp->SetIsOccluder(is_occluder);
+            }
+
+            if (is_occluder)
+            {
+                auto occluder_box = comp->GetOccluderBox();
+                bool box_changed = ImGui::DragFloat3("Occluder Center", &occluder_box.Center.x, 0.01f);
+                box_changed |= ImGui::DragFloat3("Occluder Extents", &occluder_box.Extents.x, 0.01f, 0.0f, 1000.0f);
+                if (box_changed)
+                    comp->SetOccluderBox(occluder_box);
+            }
+
             auto material = comp->material_;
 
             if (material && ImGui::CollapsingHeader("Material Properties", ImGuiTreeNodeFlags_DefaultOpen))
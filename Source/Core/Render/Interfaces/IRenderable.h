@@ -1,4 +1,5 @@
 #pragma once
+#include<span>
 #include<vector>
 #include<unordered_map>
 #include<memory>
@@ -21,6 +22,18 @@ namespace GiiGa
         virtual void Draw(RenderContext& context) =0;
         virtual SortData GetSortData() =0;
         virtual PerObjectData& GetPerObjectData() =0;
+
+        // lod is picked by SceneVisibility from GetLodDistances, renderables without LODs draw as usual
+        virtual void DrawLod(RenderContext& context, uint8_t lod)
+        {
+            Draw(context);
+        }
+
+        // Ascending view distances LOD i + 1 starts at, empty if renderable has single LOD.
+        virtual std::span<const float> GetLodDistances()
+        {
+            return {};
+        }
     };
 
     bool operator==(const std::weak_ptr<IRenderable>& lhs, const std::weak_ptr<IRenderable>& rhs)
@@ -63,29 +63,34 @@ namespace GiiGa
 
             auto cam_info = getCamInfoDataFunction_();
 
-            const auto& visibles = SceneVisibility::ExtractFromFrustum(filter_renderPass_, cam_info.camera.GetViewProj());
+            const auto viewproj = cam_info.camera.GetViewProj();
+            draw_list_.Clear();
+            SceneVisibility::ExtractDrawList({filter_renderPass_}, *SceneVisibility::FrustumCullingIds(viewproj), viewproj, draw_list_);
+            draw_list_.Sort();
 
             context.SetSignature(mask_to_pso.begin()->second.GetSignature().get());
             context.BindDescriptorHandle(0, cam_info.viewDescriptor);
 
-            for (auto& visible : visibles)
+            draw_list_.ForEachMaskRange([&](const ObjectMask& mask, std::span<const DrawItem> items)
             {
                 PSO pso;
-                if (!GetPsoFromMapByMask(mask_to_pso, visible.first, pso)) continue;
+                if (!GetPsoFromMapByMask(mask_to_pso, mask, pso)) return;
 
                 context.BindPSO(pso.GetState().get());
                 context.SetSignature(pso.GetSignature().get());
-                for (auto& common_resource_group : visible.second.common_resource_renderables)
+
+                IObjectShaderResource* bound_resource = nullptr;
+                for (const auto& item : items)
                 {
-                    auto CRG = common_resource_group.second;
-                    pso.SetShaderResources(context, *CRG.shaderResource);
-                    for (auto& renderable : common_resource_group.second.renderables)
+                    if (item.shader_resource != bound_resource)
                     {
-                        pso.SetPerObjectData(context, renderable.lock()->GetPerObjectData());
-                        renderable.lock()->Draw(context);
+                        pso.SetShaderResources(context, *item.shader_resource);
+                        bound_resource = item.shader_resource;
                     }
+                    pso.SetPerObjectData(context, item.renderable->GetPerObjectData());
+                    item.renderable->DrawLod(context, item.lod);
                 }
-            }
+            });
         }
 
     private:
@@ -97,5 +102,6 @@ namespace GiiGa
 
         std::unordered_map<ObjectMask, PSO> mask_to_pso;
         std::function<RenderPassViewData()> getCamInfoDataFunction_;
+        DrawList draw_list_;
     };
 }
@@ -113,37 +113,37 @@ namespace GiiGa
         {
             auto cam_info = getCamInfoDataFunction_();
 
-            const auto& frustum_culling_res = SceneVisibility::FrustumCulling(cam_info.camera.GetViewProj());
-
-            const auto& vis_unlit = SceneVisibility::Extract(filter_unlit_solid_, frustum_culling_res);
-            const auto& vis_translucent = SceneVisibility::Extract(filter_translucent_, frustum_culling_res);
-            std::unordered_map<ObjectMask, DrawPacket> visibles;
-            SceneVisibility::Expand(vis_unlit, visibles);
-            SceneVisibility::Expand(vis_translucent, visibles);
+            const auto viewproj = cam_info.camera.GetViewProj();
+            draw_list_.Clear();
+            SceneVisibility::ExtractDrawList({filter_unlit_solid_, filter_translucent_}, *SceneVisibility::FrustumCullingIds(viewproj), viewproj, draw_list_,
+                                             cam_info.screenDimensions.screenDimensions);
+            draw_list_.Sort();
 
             context.SetSignature(mask_to_pso.begin()->second.GetSignature().get());
             context.BindDescriptorHandle(0, cam_info.viewDescriptor);
 
             //if (visibles.size() > 0) el::Loggers::getLogger(LogRendering)->debug("some rendering visibles %v", visibles.size());
 
-            for (auto& visible : visibles)
+            draw_list_.ForEachMaskRange([&](const ObjectMask& mask, std::span<const DrawItem> items)
             {
                 PSO pso;
-                if (!GetPsoFromMapByMask(mask_to_pso, visible.first, pso)) continue;
+                if (!GetPsoFromMapByMask(mask_to_pso, mask, pso)) return;
 
                 context.BindPSO(pso.GetState().get());
                 context.SetSignature(pso.GetSignature().get());
-                for (auto& common_resource_group : visible.second.common_resource_renderables)
+
+                IObjectShaderResource* bound_resource = nullptr;
+                for (const auto& item : items)
                 {
-                    auto CRG = common_resource_group.second;
-                    pso.SetShaderResources(context, *CRG.shaderResource);
-                    for (auto& renderable : common_resource_group.second.renderables)
+                    if (item.shader_resource != bound_resource)
                     {
-                        pso.SetPerObjectData(context, renderable.lock()->GetPerObjectData());
-                        renderable.lock()->Draw(context);
+                        pso.SetShaderResources(context, *item.shader_resource);
+                        bound_resource = item.shader_resource;
                     }
+                    pso.SetPerObjectData(context, item.renderable->GetPerObjectData());
+                    item.renderable->DrawLod(context, item.lod);
                 }
-            }
+            });
         }
 
     private:
@@ -159,5 +159,6 @@ namespace GiiGa
 
         std::unordered_map<ObjectMask, PSO> mask_to_pso;
         std::function<RenderPassViewData()> getCamInfoDataFunction_;
+        DrawList draw_list_;
     };
 }
@@ -131,12 +131,11 @@ namespace GiiGa
         void Draw(RenderContext& context) override
         {
             auto cam_info = getCamInfoDataFunction_();
-            const auto& frustum_culling_res = SceneVisibility::FrustumCulling(cam_info.camera.GetViewProj());
-            const auto& vis_lit = SceneVisibility::Extract(filter_lit_solid_, frustum_culling_res);
-            const auto& vis_wire = SceneVisibility::Extract(filter_wire_, frustum_culling_res);
-            std::unordered_map<ObjectMask, DrawPacket> visibles;
-            SceneVisibility::Expand(vis_lit, visibles);
-            SceneVisibility::Expand(vis_wire, visibles);
+            const auto viewproj = cam_info.camera.GetViewProj();
+            draw_list_.Clear();
+            SceneVisibility::ExtractDrawList({filter_lit_solid_, filter_wire_}, *SceneVisibility::FrustumCullingIds(viewproj), viewproj, draw_list_,
+                                             cam_info.screenDimensions.screenDimensions);
+            draw_list_.Sort();
 
             context.SetSignature(mask_to_pso.begin()->second.GetSignature().get());
 
@@ -151,24 +150,26 @@ namespace GiiGa
             gbuffer_->ClearAll(context);
             context.BindDescriptorHandle(ViewDataRootIndex, cam_info.viewDescriptor);
 
-            for (auto& visible : visibles)
+            draw_list_.ForEachMaskRange([&](const ObjectMask& mask, std::span<const DrawItem> items)
             {
                 PSO pso;
-                if (!GetPsoFromMapByMask(mask_to_pso, visible.first, pso)) continue;
+                if (!GetPsoFromMapByMask(mask_to_pso, mask, pso)) return;
 
                 context.SetSignature(pso.GetSignature().get());
                 context.BindPSO(pso.GetState().get());
-                for (auto& common_resource_group : visible.second.common_resource_renderables)
+
+                IObjectShaderResource* bound_resource = nullptr;
+                for (const auto& item : items)
                 {
-                    auto CRG = common_resource_group.second;
-                    pso.SetShaderResources(context, *CRG.shaderResource);
-                    for (auto& renderable : common_resource_group.second.renderables)
+                    if (item.shader_resource != bound_resource)
                     {
-                        pso.SetPerObjectData(context, renderable.lock()->GetPerObjectData());
-                        renderable.lock()->Draw(context);
+                        pso.SetShaderResources(context, *item.shader_resource);
+                        bound_resource = item.shader_resource;
                     }
+                    pso.SetPerObjectData(context, item.renderable->GetPerObjectData());
+                    item.renderable->DrawLod(context, item.lod);
                 }
-            }
+            });
         }
 
     private:
@@ -187,5 +188,6 @@ namespace GiiGa
         std::unordered_map<ObjectMask, PSO> mask_to_pso;
         std::function<RenderPassViewData()> getCamInfoDataFunction_;
         std::shared_ptr<GBuffer> gbuffer_;
+        DrawList draw_list_;
     };
 }
@@ -230,10 +230,13 @@ namespace GiiGa
         {
             auto cam_info = getCamInfoDataFunction_();
 
-            auto visibles = SceneVisibility::ExtractFromFrustum(filter_pointLight_, cam_info.camera.GetViewProj());
+            const auto viewproj = cam_info.camera.GetViewProj();
+            draw_list_.Clear();
+            SceneVisibility::ExtractDrawList({filter_pointLight_}, *SceneVisibility::FrustumCullingIds(viewproj), viewproj, draw_list_);
 
             // Frustum culling should not work for directional lighting.
-            SceneVisibility::ExpandByFilterFromAll(filter_directionalLight_, visibles);
+            SceneVisibility::ExtractDrawList({filter_directionalLight_}, SceneVisibility::AllIds(), viewproj, draw_list_);
+            draw_list_.Sort();
 
             context.SetSignature(shade_mask_to_pso.begin()->second.GetSignature().get());
             context.BindDescriptorHandle(ViewDataRootIndex, cam_info.viewDescriptor);
@@ -251,47 +254,49 @@ namespace GiiGa
             context.BindDescriptorHandle(ConstantBufferCount + 2, gbuffer_->GetSRV(GBuffer::GBufferOrder::NormalWS));
             context.BindDescriptorHandle(ConstantBufferCount + 3, gbuffer_->GetDepthSRV());
 
-            for (auto& visible : visibles)
+            draw_list_.ForEachMaskRange([&](const ObjectMask& mask, std::span<const DrawItem> items)
             {
                 PSO shade_pso;
-                if (!GetPsoFromMapByMask(shade_mask_to_pso, visible.first, shade_pso)) continue;
+                if (!GetPsoFromMapByMask(shade_mask_to_pso, mask, shade_pso)) return;
 
-                for (auto& common_resource_group : visible.second.common_resource_renderables)
+                IObjectShaderResource* bound_resource = nullptr;
+                for (const auto& item : items)
                 {
-                    shade_pso.SetShaderResources(context, *common_resource_group.second.shaderResource);
+                    if (item.shader_resource != bound_resource)
+                    {
+                        shade_pso.SetShaderResources(context, *item.shader_resource);
+                        bound_resource = item.shader_resource;
+                    }
+
+                    gbuffer_->ClearStencil(context, 1);
 
-                    for (auto& renderable : common_resource_group.second.renderables)
+                    if (!filter_directionalLight_.CoversMask(item.object_mask))
+                    {
+                        // unmar
+                        context.BindPSO(unmark_pso.GetState().get());
+                        unmark_pso.SetPerObjectData(context, item.renderable->GetPerObjectData());
+                        context.GetGraphicsCommandList()->OMSetRenderTargets(0, nullptr,
+                                                                             false, &depth);
+                        item.renderable->DrawLod(context, item.lod);
+                    }
+                    else if (auto dir_light = dynamic_cast<DirectionalLightComponent*>(item.renderable))
                     {
-                        gbuffer_->ClearStencil(context, 1);
-
-                        if (!filter_directionalLight_.CoversMask(renderable.lock()->GetSortData().object_mask))
-                        {
-                            // unmar
-                            context.BindPSO(unmark_pso.GetState().get());
-                            unmark_pso.SetPerObjectData(context, renderable.lock()->GetPerObjectData());
-                            context.GetGraphicsCommandList()->OMSetRenderTargets(0, nullptr,
-                                                                                 false, &depth);
-                            renderable.lock()->Draw(context);
-                        }
-                        else if (auto dir_light = std::dynamic_pointer_cast<DirectionalLightComponent>(renderable.lock()))
-                        {
-                            dir_light->TransitionDepthShadowResource(context, D3D12_RESOURCE_STATE_DEPTH_READ | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-                            context.BindDescriptorHandle(ConstantBufferCount + 3, dir_light->GetShadowSRV()); // в теории работает для любого света, но пока по***
-                            context.BindDescriptorHandle(ConstantBufferCount + 4, dir_light->GetCascadeDataSRV());
-                        }
-
-                        {
-                            // shade
-                            context.BindPSO(shade_pso.GetState().get());
-                            shade_pso.SetPerObjectData(context, renderable.lock()->GetPerObjectData());
-                            context.GetGraphicsCommandList()->OMSetRenderTargets(1, &accum,
-                                                                                 false, &depth);
-                            context.GetGraphicsCommandList()->OMSetStencilRef(1);
-                            renderable.lock()->Draw(context);
-                        }
+                        dir_light->TransitionDepthShadowResource(context, D3D12_RESOURCE_STATE_DEPTH_READ | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+                        context.BindDescriptorHandle(ConstantBufferCount + 3, dir_light->GetShadowSRV()); // в теории работает для любого света, но пока по***
+                        context.BindDescriptorHandle(ConstantBufferCount + 4, dir_light->GetCascadeDataSRV());
+                    }
+
+                    {
+                        // shade
+                        context.BindPSO(shade_pso.GetState().get());
+                        shade_pso.SetPerObjectData(context, item.renderable->GetPerObjectData());
+                        context.GetGraphicsCommandList()->OMSetRenderTargets(1, &accum,
+                                                                             false, &depth);
+                        context.GetGraphicsCommandList()->OMSetStencilRef(1);
+                        item.renderable->DrawLod(context, item.lod);
                     }
                 }
-            }
+            });
         }
 
     private:
@@ -307,5 +312,6 @@ namespace GiiGa
         PSO unmark_pso;
         std::function<RenderPassViewData()> getCamInfoDataFunction_;
         std::shared_ptr<GBuffer> gbuffer_;
+        DrawList draw_list_;
     };
 }
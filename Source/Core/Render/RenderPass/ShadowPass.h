@@ -22,6 +22,7 @@
 #include<IRenderable.h>
 #include<LightComponent.h>
 #include<DirectionalLightComponent.h>
+#include<ArchetypeStorage.h>
 
 namespace GiiGa
 {
@@ -79,114 +80,80 @@ namespace GiiGa
 
             context.SetSignature(mask_to_pso.begin()->second.GetSignature().get());
 
-            std::unordered_map<ObjectMask, DrawPacket> lights;
-            SceneVisibility::ExpandByFilterFromAll(filter_lights_, lights);
+            const auto cam_viewproj = cam_info.camera.GetViewProj();
+            GatherDirectionalLights(cam_viewproj);
 
-            /*
-            ImGui::Begin("Shadow Pass");
-            if (ImGui::InputInt("DepthBias", &DepthBias) || ImGui::InputFloat("DepthBiasClamp", &DepthBiasClamp) || ImGui::InputFloat("SlopeScaledDepthBias", &SlopeScaledDepthBias))
+            for (auto* dirLight : directional_lights_)
             {
-                mask_to_pso.erase(filter_objects_);
-                D3D12_RASTERIZER_DESC rast_desc = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
-                rast_desc.CullMode = D3D12_CULL_MODE_BACK;
-                rast_desc.FrontCounterClockwise = TRUE;
-                rast_desc.DepthBias = DepthBias;
-                rast_desc.DepthBiasClamp = DepthBiasClamp;
-                rast_desc.SlopeScaledDepthBias = SlopeScaledDepthBias;
-
-                D3D12_DEPTH_STENCIL_DESC depth_stencil_desc = CD3DX12_DEPTH_STENCIL_DESC(D3D12_DEFAULT);
-
-                auto sampler_desc = D3D12_STATIC_SAMPLER_DESC{
-                    .Filter = D3D12_FILTER_COMPARISON_MIN_MAG_LINEAR_MIP_POINT,
-                    .AddressU = D3D12_TEXTURE_ADDRESS_MODE_BORDER,
-                    .AddressV = D3D12_TEXTURE_ADDRESS_MODE_BORDER,
-                    .AddressW = D3D12_TEXTURE_ADDRESS_MODE_BORDER,
-                    .ComparisonFunc = D3D12_COMPARISON_FUNC_LESS_EQUAL,
-                    .BorderColor = D3D12_STATIC_BORDER_COLOR_TRANSPARENT_BLACK,
-                    .MinLOD = 0,
-                    .MaxLOD = D3D12_FLOAT32_MAX
-                };
-
-                mask_to_pso[filter_objects_]
-                    .set_vs(ShaderManager::GetShaderByName(CascadeShadowShader))
-                    .set_gs(ShaderManager::GetShaderByName(CascadeShadowGeomShader))
-                    .set_rasterizer_state(rast_desc)
-                    .set_input_layout(VertexPNTBT::InputLayout)
-                    .set_dsv_format(DXGI_FORMAT_D32_FLOAT)
-                    .set_depth_stencil_state(depth_stencil_desc)
-                    .SetPerObjectDataFunction([](RenderContext& context, PerObjectData& per_obj)
-                    {
-                        context.BindDescriptorHandle(ModelDataRootIndex, per_obj.GetDescriptor());
-                    })
-                    .add_static_samplers(sampler_desc)
-                    .GeneratePSO(context.GetDevice(), ConstantBufferCount, SRVCount);
-            }
-            ImGui::End();
-            */
-            
+                const auto dsv = dirLight->GetShadowDSV();
+                dirLight->TransitionDepthShadowResource(context, D3D12_RESOURCE_STATE_DEPTH_WRITE);
+                context.GetGraphicsCommandList()->OMSetRenderTargets(0, nullptr, true, &dsv);
+                dirLight->ClearShadowDSV(context);
+                dirLight->UpdateCascadeGPUData(context, cam_info.camera);
+                const D3D12_GPU_DESCRIPTOR_HANDLE shadow_srv = dirLight->GetCascadeDataSRV();
+                const D3D12_GPU_DESCRIPTOR_HANDLE light_srv = dirLight->GetLightDataSRV();
+                context.GetGraphicsCommandList()->RSSetViewports(1, dirLight->GetShadowViewport());
+                context.GetGraphicsCommandList()->RSSetScissorRects(1, dirLight->GetShadowScissorRect());
+
+                const auto lightViews = dirLight->GetViews();
+                std::vector<CullingViewDesc> cascade_views;
+                cascade_views.reserve(lightViews.size());
+                for (const auto& view : lightViews)
+                {
+                    cascade_views.push_back({view});
+                }
 
-            for (const auto& [mask, lightPacket] : lights)
-            {
-                for (const auto lightGroup : lightPacket.common_resource_renderables)
+                // all cascades are drawn at once through geometry shader, so union of cascade visibility is enough
+                const auto cascades_culling = SceneVisibility::CullViews(cascade_views);
+                draw_list_.Clear();
+                SceneVisibility::ExtractDrawList({filter_objects_}, cascades_culling->ids, cam_viewproj, draw_list_);
+                draw_list_.Sort();
+
+                draw_list_.ForEachMaskRange([&](const ObjectMask& mask, std::span<const DrawItem> items)
                 {
-                    for (const auto rendLight : lightGroup.second.renderables)
+                    PSO pso;
+                    if (!GetPsoFromMapByMask(mask_to_pso, mask, pso)) return;
+                    context.SetSignature(pso.GetSignature().get());
+                    context.BindPSO(pso.GetState().get());
+                    context.BindDescriptorHandle(ConstantBufferCount + StructuredBufferShadowRootIndex, shadow_srv);
+                    context.BindDescriptorHandle(DirectionalDataRootIndex, light_srv);
+
+                    for (const auto& item : items)
                     {
-                        // Should be only Directional light
-                        const auto light = std::dynamic_pointer_cast<LightComponent>(rendLight.lock());
-                        if (!light) continue;
-
-                        D3D12_GPU_DESCRIPTOR_HANDLE shadow_srv;
-                        D3D12_GPU_DESCRIPTOR_HANDLE light_srv;
-                        if (const auto dirLight = std::dynamic_pointer_cast<DirectionalLightComponent>(light))
-                        {
-                            const auto dsv = dirLight->GetShadowDSV();
-                            dirLight->TransitionDepthShadowResource(context, D3D12_RESOURCE_STATE_DEPTH_WRITE);
-                            context.GetGraphicsCommandList()->OMSetRenderTargets(0, nullptr, true, &dsv);
-                            dirLight->ClearShadowDSV(context);
-                            dirLight->UpdateCascadeGPUData(context, cam_info.camera);
-                            shadow_srv = dirLight->GetCascadeDataSRV();
-                            light_srv = dirLight->GetLightDataSRV();
-                            context.GetGraphicsCommandList()->RSSetViewports(1, dirLight->GetShadowViewport());
-                            context.GetGraphicsCommandList()->RSSetScissorRects(1, dirLight->GetShadowScissorRect());
-                        }
-                        else continue;
-
-                        const auto lightViews = light->GetViews();
-                        std::unordered_map<ObjectMask, DrawPacket> visibles;
-
-                        for (const auto view : lightViews)
-                        {
-                            SceneVisibility::ExpandByFilterFromFrustum(filter_objects_, view, visibles);
-                        }
-
-                        for (auto& visible : visibles)
-                        {
-                            PSO pso;
-                            if (!GetPsoFromMapByMask(mask_to_pso, visible.first, pso)) continue;
-                            context.SetSignature(pso.GetSignature().get());
-                            context.BindPSO(pso.GetState().get());
-                            context.BindDescriptorHandle(ConstantBufferCount + StructuredBufferShadowRootIndex, shadow_srv);
-                            context.BindDescriptorHandle(DirectionalDataRootIndex, light_srv);
-
-                            for (auto& common_resource_group : visible.second.common_resource_renderables)
-                            {
-                                //auto CRG = common_resource_group.second;
-                                //pso.SetShaderResources(context, *CRG.shaderResource);
-                                for (auto& renderable : common_resource_group.second.renderables)
-                                {
-                                    pso.SetPerObjectData(context, renderable.lock()->GetPerObjectData());
-                                    renderable.lock()->Draw(context);
-                                }
-                            }
-                        }
+                        pso.SetPerObjectData(context, item.renderable->GetPerObjectData());
+                        item.renderable->DrawLod(context, item.lod);
                     }
-                }
+                });
             }
 
             ResetVieports(context, cam_info.screenDimensions.screenDimensions);
         }
 
     protected:
+        // Directional lights are not culled, with archetype storage their column is walked directly
+        // instead of filtering every registered renderable by mask.
+        void GatherDirectionalLights(const DirectX::SimpleMath::Matrix& cam_viewproj)
+        {
+            directional_lights_.clear();
+            if (ArchetypeStorageSettings::Enabled)
+            {
+                ArchetypeStorage::GetInstance().ForEach<DirectionalLightComponent>([&](IGameObject&, DirectionalLightComponent& light)
+                {
+                    if (light.IsInVisibility())
+                        directional_lights_.push_back(&light);
+                });
+                return;
+            }
+
+            lights_list_.Clear();
+            SceneVisibility::ExtractDrawList({filter_lights_}, SceneVisibility::AllIds(), cam_viewproj, lights_list_);
+            for (const auto& light_item : lights_list_.Items())
+            {
+                if (const auto light = dynamic_cast<DirectionalLightComponent*>(light_item.renderable))
+                    directional_lights_.push_back(light);
+            }
+        }
+
         void ResetVieports(RenderContext& context, const Vector2& screen)
         {
             D3D12_VIEWPORT viewport;
@@ -221,6 +188,9 @@ namespace GiiGa
 
         std::unordered_map<ObjectMask, PSO> mask_to_pso;
         std::function<RenderPassViewData()> getCamInfoDataFunction_;
+        DrawList lights_list_;
+        std::vector<DirectionalLightComponent*> directional_lights_;
+        DrawList draw_list_;
         int DepthBias = -15000;
         float DepthBiasClamp = 0;
         float SlopeScaledDepthBias = 8.000;
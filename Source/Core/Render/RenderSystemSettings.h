@@ -33,5 +33,50 @@ namespace GiiGa
             1024 // D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER
         };
     };
-    
+
+    enum class CullingBackend
+    {
+        // hierarchical test over OctreeBoxMap
+        Octree,
+        // brute-force SIMD sweep over all AABBs, faster on dense scenes below ~50k objects
+        LinearSIMD
+    };
+
+    struct SceneVisibilitySettings
+    {
+        // can be switched at runtime, e.g. per level
+        static inline CullingBackend Backend = CullingBackend::Octree;
+
+        // share of dynamic entries changed since last Tick, static ones live in the bvh
+        // after which octree is rebuilt from scratch instead of patched
+        static inline float RebuildChurnThreshold = 0.25f;
+
+        static inline uint32_t OctreeMaxDepth = 10;
+        static inline uint32_t OctreeMaxElementsInNode = 20;
+
+        // CPU occlusion culling of camera views after frustum culling
+        static inline bool OcclusionCulling = false;
+        static inline uint32_t OcclusionBufferWidth = 256;
+        static inline uint32_t OcclusionBufferHeight = 128;
+
+        // reuse culling of a view from previous frames while camera barely moves,
+        // only entries near frustum border and entries moved since are re-tested
+        static inline bool TemporalCulling = false;
+        // every view is culled from scratch, e.g. after camera cut
+        static inline bool ForceFullCulling = false;
+        // max element-wise difference of view-projection from the one cache was built for, picks the cache
+        static inline float TemporalMaxViewDelta = 0.01f;
+        // width (world units) of band around frustum planes whose entries are re-tested every frame,
+        // cache is rebuilt once any frustum corner moved further than this
+        static inline float TemporalBorderMargin = 2.0f;
+        // cache is rebuilt at least this often to bound drift
+        static inline uint32_t TemporalMaxFrames = 30;
+        // share of registered entries moved since cache was built after which it is rebuilt
+        static inline float TemporalMaxMovedShare = 0.1f;
+
+        // entries whose projected bounds are smaller than this many pixels on both axes are not drawn, 0 - disabled
+        static inline float SmallFeatureCullingPixels = 0.0f;
+        // multiplies view distance before it is looked up in renderable's LOD distances
+        static inline float LodDistanceScale = 1.0f;
+    };
 }
\ No newline at end of file
@@ -10,18 +10,83 @@
 
 
 
+#include<array>
 #include<memory>
 #include<vector>
 #include<limits>
+#include<cmath>
+#include<optional>
+#include<span>
+#include<algorithm>
 #include<unordered_map>
+#include<unordered_set>
 
 #include<IRenderable.h>
 #include<ObjectMask.h>
 #include<DXMathUtils.h>
 #include<Logger.h>
+#include<RenderSystemSettings.h>
+#include<CullingStorageSoA.h>
+#include<DrawList.h>
+#include<SoftwareOcclusion.h>
+#include<StaticBVH.h>
+#include<TransformSystem.h>
 
 namespace GiiGa
 {
+    // Generational handle of SceneVisibility entry.
+    // index is stable while entry lives and is the id octree and culling results use,
+    // generation tells apart entries that reused the same index.
+    struct VisibilityHandle
+    {
+        static constexpr uint32_t InvalidIndex = std::numeric_limits<uint32_t>::max();
+
+        uint32_t index = InvalidIndex;
+        uint32_t generation = 0;
+
+        bool operator==(const VisibilityHandle&) const = default;
+    };
+
+    struct VisibilityRaycastHit
+    {
+        VisibilityHandle handle;
+        // along normalized ray direction, 0 when ray starts inside the box
+        float distance;
+    };
+
+    struct VisibilityNearestHit
+    {
+        VisibilityHandle handle;
+        // from query point to the box, 0 when point is inside
+        float distance;
+    };
+
+    struct CullingViewDesc
+    {
+        DirectX::SimpleMath::Matrix viewproj;
+    };
+
+    // Result of SceneVisibility::CullViews:
+    // ids[i] is visible in every view whose bit is set in view_masks[i]
+    struct MultiViewCullingResult
+    {
+        std::vector<OrthoTree::index_t> ids;
+        std::vector<uint64_t> view_masks;
+    };
+
+    // Counters of SceneVisibility temporal culling since last reset.
+    struct TemporalCullingStats
+    {
+        uint64_t temporal_hits = 0;
+        uint64_t full_culls = 0;
+
+        float HitRate() const
+        {
+            const uint64_t total = temporal_hits + full_culls;
+            return total ? static_cast<float>(temporal_hits) / static_cast<float>(total) : 0.0f;
+        }
+    };
+
     //todo: add sorted Extract
     class SceneVisibility
     {
@@ -84,41 +149,128 @@ namespace GiiGa
 
         //virtual ~SceneVisibility() = default;
 
-        static std::vector<std::weak_ptr<IRenderable>> FrustumCulling(DirectX::SimpleMath::Matrix viewproj)
+        static constexpr float FrustumCullingTolerance = 0.1f;
+
+        // Returns ids of entries intersecting frustum, using backend selected in SceneVisibilitySettings.
+        // Result is cached until scene changes or next Tick, so passes culling same camera share it.
+        // Returned ids stay valid when scene changes while caller still uses them.
+        static std::shared_ptr<const std::vector<OrthoTree::index_t>> FrustumCullingIds(DirectX::SimpleMath::Matrix viewproj)
         {
-            // Extract frustum planes from the view-projection matrix.
-            auto dxplanes = ExtractFrustumPlanesPointInside(viewproj);
-            auto otplanes = std::vector<OrthoTree::Plane3D>(6);
+            auto& inst = GetInstance();
 
-            // Convert DirectX frustum planes to OrthoTree's Plane3D format.
-            for (int i = 0; i < 6; i++)
+            if (const auto* cached = inst->FindCachedView(viewproj))
+                return cached->ids;
+
+            auto ids = std::make_shared<std::vector<OrthoTree::index_t>>(
+                SceneVisibilitySettings::TemporalCulling ? inst->TemporalCull(viewproj) : CullSingleView(viewproj));
+            OcclusionStats occlusion_stats;
+            if (SceneVisibilitySettings::OcclusionCulling)
+                inst->OcclusionCulling(viewproj, *ids, occlusion_stats);
+            inst->frame_single_view_cache_.push_back(CachedViewCulling{viewproj, ids, occlusion_stats});
+            return ids;
+        }
+
+        static const TemporalCullingStats& GetTemporalCullingStats()
+        {
+            return GetInstance()->temporal_stats_;
+        }
+
+        static void ResetTemporalCullingStats()
+        {
+            GetInstance()->temporal_stats_ = {};
+        }
+
+        // Occluder/occludee counters of the last FrustumCullingIds for this view in current frame.
+        static OcclusionStats GetOcclusionStats(const DirectX::SimpleMath::Matrix& viewproj)
+        {
+            if (const auto* cached = GetInstance()->FindCachedView(viewproj))
+                return cached->occlusion_stats;
+            return {};
+        }
+
+        // Entry with proxy rasterizes it into occlusion buffer when visible, nullopt makes entry a plain occludee.
+        // Proxy is a box in space of world matrix that has to lie inside the solid part of the mesh,
+        // bound transform keeps its world matrix up to date.
+        static void SetOccluder(VisibilityHandle handle, std::optional<DirectX::BoundingBox> local_proxy, const Matrix& world = Matrix::Identity)
+        {
+            auto& inst = GetInstance();
+            auto& occluder = inst->occluders_[inst->DenseIndexChecked(handle)];
+            if (local_proxy)
+                occluder = OccluderProxy{*local_proxy, world};
+            else
+                occluder.reset();
+            inst->InvalidateFrameCache();
+        }
+
+        // Culls several views in one sweep over registered entries, e.g. shadow cascades.
+        // Up to 64 views, result is cached until scene changes or next Tick.
+        static std::shared_ptr<const MultiViewCullingResult> CullViews(std::span<const CullingViewDesc> views)
+        {
+            if (views.size() > 64)
+                throw std::runtime_error("SceneVisibility::CullViews(): more than 64 views");
+
+            auto& inst = GetInstance();
+
+            for (const auto& [cached_views, cached_result] : inst->frame_multi_view_cache_)
             {
-                auto dxnorm = dxplanes[i].Normal();
+                if (std::equal(cached_views.begin(), cached_views.end(), views.begin(), views.end(),
+                               [](const Matrix& lhs, const CullingViewDesc& rhs) { return lhs == rhs.viewproj; }))
+                    return cached_result;
+            }
 
-                if (!(std::abs(dxnorm.LengthSquared() - 1.0) < 0.000001))
+            std::vector<Matrix> views_key;
+            std::vector<std::vector<Plane>> views_planes;
+            views_key.reserve(views.size());
+            views_planes.reserve(views.size());
+            for (const auto& view : views)
+            {
+                views_key.push_back(view.viewproj);
+                views_planes.push_back(ExtractFrustumPlanesPointInside(view.viewproj));
+            }
+
+            auto shared_result = std::make_shared<MultiViewCullingResult>();
+            auto& result = *shared_result;
+            inst->static_bvh_.MultiFrustumCulling(views_planes, FrustumCullingTolerance, result.ids, result.view_masks);
+
+            // bvh keeps entries unregistered or made dynamic since last Tick
+            size_t kept = 0;
+            for (size_t i = 0; i < result.ids.size(); ++i)
+            {
+                if (inst->IsStaticId(result.ids[i]))
                 {
-                    el::Loggers::getLogger(LogWorld)->error("Length %v", dxnorm.LengthSquared());
-                    throw std::runtime_error("Plane Normal Length error");
+                    result.ids[kept] = result.ids[i];
+                    result.view_masks[kept] = result.view_masks[i];
+                    ++kept;
                 }
-
-                OrthoTree::Vector3D normal = {dxnorm.x, dxnorm.y, dxnorm.z};
-                otplanes[i] = OrthoTree::Plane3D(dxplanes[i].D(), normal);
             }
+            result.ids.resize(kept);
+            result.view_masks.resize(kept);
 
-            // Perform frustum culling to get IDs of visible entities.
+            inst->dynamic_storage_.MultiFrustumCulling(views_planes, FrustumCullingTolerance, result.ids, result.view_masks);
+            inst->frame_multi_view_cache_.emplace_back(std::move(views_key), shared_result);
+            return shared_result;
+        }
+
+        static std::vector<std::weak_ptr<IRenderable>> RenderablesFromIds(const std::vector<OrthoTree::index_t>& ent_ids)
+        {
             auto& inst = GetInstance();
-            auto ent_ids = inst->quadtree.FrustumCulling(otplanes, 0.1, inst->visibility_to_geometry_);
 
             std::vector<std::weak_ptr<IRenderable>> result;
+            result.reserve(ent_ids.size());
             for (auto ent_id : ent_ids)
             {
-                // Attempt to lock and retrieve the renderable object.
-                if (!inst->visibility_to_renderable_[ent_id].expired())
-                    result.push_back(inst->visibility_to_renderable_[ent_id]);
+                const uint32_t dense = inst->DenseIndex(ent_id);
+                if (dense != VisibilityHandle::InvalidIndex && !inst->renderables_[dense].expired())
+                    result.push_back(inst->renderables_[dense]);
             }
             return result;
         }
 
+        static std::vector<std::weak_ptr<IRenderable>> FrustumCulling(DirectX::SimpleMath::Matrix viewproj)
+        {
+            return RenderablesFromIds(*FrustumCullingIds(viewproj));
+        }
+
         // Extract visible objects matching a filter and organize them into draw packets.
         static std::unordered_map<ObjectMask, DrawPacket> Extract(ObjectMask render_filter_type, const std::vector<std::weak_ptr<IRenderable>>& renderables)
         {
@@ -167,6 +319,164 @@ namespace GiiGa
             return mask_to_draw_packets;
         }
 
+        // Appends renderables from ent_ids covered by any of filters to draw_list, depth is taken from AABB center in viewproj.
+        // LOD is picked by view distance of AABB center. When screen_size (pixels) is given, entries smaller than
+        // SceneVisibilitySettings::SmallFeatureCullingPixels are dropped.
+        // Call draw_list.Sort() once everything for the pass is appended.
+        static void ExtractDrawList(std::initializer_list<ObjectMask> render_filters, const std::vector<OrthoTree::index_t>& ent_ids,
+                                    const DirectX::SimpleMath::Matrix& viewproj, DrawList& draw_list,
+                                    const DirectX::SimpleMath::Vector2& screen_size = {})
+        {
+            auto& inst = GetInstance();
+            const float min_pixels = SceneVisibilitySettings::SmallFeatureCullingPixels;
+            const bool cull_small = min_pixels > 0.0f && screen_size.x > 0.0f && screen_size.y > 0.0f;
+
+            for (auto ent_id : ent_ids)
+            {
+                const uint32_t dense = inst->DenseIndex(ent_id);
+                if (dense == VisibilityHandle::InvalidIndex)
+                    continue;
+
+                std::shared_ptr<IRenderable> renderable = inst->renderables_[dense].lock();
+                if (!renderable)
+                    continue;
+
+                auto sort_data = renderable->GetSortData();
+                const bool is_covered = std::any_of(render_filters.begin(), render_filters.end(),
+                                                    [&](const ObjectMask& filter) { return filter.CoversMask(sort_data.object_mask); });
+                if (!is_covered)
+                    continue;
+
+                const auto& box = inst->boxes_[dense];
+                if (cull_small && ProjectedPixelSize(box, viewproj, screen_size) < min_pixels)
+                    continue;
+
+                const Vector4 center{
+                    static_cast<float>((box.Min[0] + box.Max[0]) * 0.5),
+                    static_cast<float>((box.Min[1] + box.Max[1]) * 0.5),
+                    static_cast<float>((box.Min[2] + box.Max[2]) * 0.5),
+                    1.0f
+                };
+                const Vector4 clip_center = Vector4::Transform(center, viewproj);
+                const float depth = clip_center.w != 0.0f ? clip_center.z / clip_center.w : clip_center.z;
+
+                // w of perspective projection is view space distance along camera axis
+                uint8_t lod = 0;
+                const auto lod_distances = renderable->GetLodDistances();
+                if (!lod_distances.empty())
+                {
+                    const float distance = clip_center.w * SceneVisibilitySettings::LodDistanceScale;
+                    lod = static_cast<uint8_t>(std::upper_bound(lod_distances.begin(), lod_distances.end(), distance) - lod_distances.begin());
+                }
+
+                draw_list.Add(renderable.get(), sort_data, depth, lod);
+            }
+        }
+
+        // Ids of all registered entries, for passes that skip culling (e.g. directional lights).
+        static const std::vector<OrthoTree::index_t>& AllIds()
+        {
+            return GetInstance()->culling_storage_.Ids();
+        }
+
+        /*
+         * Spatial queries over registered AABBs.
+         * Static entries are searched through the bvh, dynamic ones through their packed storage,
+         * while static changes wait for Tick every entry is swept instead.
+         * They only read entry storage and write into caller's spans, nothing is allocated,
+         * so they may run from several threads at once during read-only phase of the frame:
+         * after GameObjects tick and until the next one, i.e. while RenderSystem ticks.
+         * Register/Unregister/Update (component init, transform changes) must not run concurrently.
+         * Overlap queries return number of entries found, only first result.size() of them are written.
+         * Ray queries with zero or non-finite direction find nothing.
+         */
+
+        static std::optional<VisibilityRaycastHit> Raycast(const DirectX::SimpleMath::Vector3& origin, DirectX::SimpleMath::Vector3 direction,
+                                                           float max_distance = std::numeric_limits<float>::max())
+        {
+            const auto& inst = GetInstance();
+            Vector3 inv_direction;
+            if (!InverseDirection(direction, inv_direction))
+                return std::nullopt;
+
+            std::optional<VisibilityRaycastHit> closest;
+            inst->QueryRayHits(origin, inv_direction, max_distance, [&](OrthoTree::index_t ent_id, float distance)
+            {
+                if (!closest || distance < closest->distance)
+                    closest = VisibilityRaycastHit{inst->HandleOfId(ent_id), distance};
+                return closest->distance;
+            });
+            return closest;
+        }
+
+        // Writes hits sorted by distance, keeps the nearest result.size() of them. Returns number written.
+        static size_t RaycastAll(const DirectX::SimpleMath::Vector3& origin, DirectX::SimpleMath::Vector3 direction, float max_distance,
+                                 std::span<VisibilityRaycastHit> result)
+        {
+            const auto& inst = GetInstance();
+            Vector3 inv_direction;
+            if (result.empty() || !InverseDirection(direction, inv_direction))
+                return 0;
+
+            size_t written = 0;
+            inst->QueryRayHits(origin, inv_direction, max_distance, [&](OrthoTree::index_t ent_id, float distance)
+            {
+                return PushNearest(result, written, VisibilityRaycastHit{inst->HandleOfId(ent_id), distance}, max_distance);
+            });
+            SortNearest(result, written);
+            return written;
+        }
+
+        static size_t OverlapAABB(const DirectX::BoundingBox& box, std::span<VisibilityHandle> result)
+        {
+            const auto& inst = GetInstance();
+            const Vector3 center = box.Center;
+            const Vector3 extents = box.Extents;
+
+            size_t found = 0;
+            inst->QueryOverlapBox(center - extents, center + extents, [&](OrthoTree::index_t ent_id)
+            {
+                if (found < result.size())
+                    result[found] = inst->HandleOfId(ent_id);
+                ++found;
+            });
+            return found;
+        }
+
+        static size_t OverlapSphere(const DirectX::BoundingSphere& sphere, std::span<VisibilityHandle> result)
+        {
+            const auto& inst = GetInstance();
+
+            size_t found = 0;
+            inst->QueryOverlapSphere(sphere.Center, sphere.Radius, [&](OrthoTree::index_t ent_id)
+            {
+                if (found < result.size())
+                    result[found] = inst->HandleOfId(ent_id);
+                ++found;
+            });
+            return found;
+        }
+
+        // result.size() nearest entries to point, sorted by distance. Returns number written.
+        static size_t KNearest(const DirectX::SimpleMath::Vector3& point, std::span<VisibilityNearestHit> result)
+        {
+            const auto& inst = GetInstance();
+            if (result.empty())
+                return 0;
+
+            // squared distances while searching, converted once at the end
+            size_t written = 0;
+            inst->QueryNearest(point, [&](OrthoTree::index_t ent_id, float distance_sq)
+            {
+                return PushNearest(result, written, VisibilityNearestHit{inst->HandleOfId(ent_id), distance_sq}, std::numeric_limits<float>::max());
+            });
+            SortNearest(result, written);
+
+            for (size_t i = 0; i < written; ++i)
+                result[i].distance = std::sqrt(result[i].distance);
+            return written;
+        }
+
         static std::unordered_map<ObjectMask, DrawPacket> ExtractFromFrustum(ObjectMask render_filter_type, DirectX::SimpleMath::Matrix viewproj)
         {
             const auto& culling = FrustumCulling(viewproj);
@@ -189,22 +499,17 @@ namespace GiiGa
                         else
                         {
                             auto common_resourceGroup = common_packet->second.common_resource_renderables.find(shaderResource);
+                            auto& com_rends = common_resourceGroup->second.renderables;
+
+                            std::unordered_set<const IRenderable*> contained;
+                            contained.reserve(com_rends.size() + resourceGroup.renderables.size());
+                            for (const auto& com_rend : com_rends)
+                                contained.insert(com_rend.lock().get());
+
                             for (const auto& renderable : resourceGroup.renderables)
                             {
-                                //auto& com_rend = common_resourceGroup.renderables;
-                                bool contains = false;
-                                for (auto& com_rend : common_resourceGroup->second.renderables)
-                                {
-                                    if (com_rend == renderable)
-                                    {
-                                        contains = true;
-                                        break;
-                                    }
-                                }
-                                if (!contains)
-                                {
-                                    common_resourceGroup->second.renderables.push_back(renderable);
-                                }
+                                if (contained.insert(renderable.lock().get()).second)
+                                    com_rends.push_back(renderable);
                             }
                         }
                     }
@@ -215,7 +520,7 @@ namespace GiiGa
         static void ExpandByFilterFromAll(ObjectMask render_filter_type, std::unordered_map<ObjectMask, DrawPacket>& result_packets)
         {
             // Iterate through each entity ID from frustum culling.
-            for (const auto& [ent_id, renderable] : GetInstance()->visibility_to_renderable_)
+            for (const auto& renderable : GetInstance()->renderables_)
             {
                 // Attempt to lock and retrieve the renderable object.
 
@@ -257,26 +562,60 @@ namespace GiiGa
             Expand(res, result_packets);
         }
 
+        // Applies Register/Unregister/Update made since last Tick to the spatial indices.
+        // Static bvh is rebuilt when static entries were added or removed and refit when they moved.
+        // Octree patches only changed dynamic entries, falls back to full rebuild when too many changed.
         static void Tick()
         {
-            GetInstance()->quadtree = OrthoTree::OctreeBoxMap
+            auto& inst = GetInstance();
+            inst->InvalidateFrameCache();
+
+            ++inst->frame_index_;
+            std::erase_if(inst->temporal_views_, [&inst](const TemporalView& view) { return view.last_used_frame + 1 < inst->frame_index_; });
+
+            if (inst->static_rebuild_pending_)
+                inst->RebuildStaticBVH();
+            else if (inst->static_refit_pending_)
+                inst->static_bvh_.Refit([&inst](OrthoTree::index_t ent_id) { return inst->boxes_[inst->slots_[ent_id].dense]; });
+            inst->static_rebuild_pending_ = false;
+            inst->static_refit_pending_ = false;
+
+            // linear backend does not need the tree, it is rebuilt once octree backend is selected again
+            if (SceneVisibilitySettings::Backend == CullingBackend::LinearSIMD)
             {
-                GetInstance()->visibility_to_geometry_,
-                10,
-                OrthoTree::BoundingBox3D{
-                    {
-                        -std::numeric_limits<float>::max(),
-                        -std::numeric_limits<float>::max(),
-                        -std::numeric_limits<float>::max()
-                    },
-                    {
-                        std::numeric_limits<float>::max(),
-                        std::numeric_limits<float>::max(),
-                        std::numeric_limits<float>::max()
-                    }
-                },
-                20
-            };
+                inst->pending_changes_.clear();
+                inst->tree_geometry_.clear();
+                inst->is_tree_built_ = false;
+                return;
+            }
+
+            if (inst->pending_changes_.empty() && inst->is_tree_built_)
+                return;
+
+            const auto churn_limit = SceneVisibilitySettings::RebuildChurnThreshold * static_cast<float>(inst->dynamic_storage_.Size());
+            if (!inst->is_tree_built_ || static_cast<float>(inst->pending_changes_.size()) > churn_limit)
+            {
+                inst->RebuildTree();
+                return;
+            }
+
+            for (const auto& [ent_id, in_tree_box] : inst->pending_changes_)
+            {
+                // entries made static leave the tree the same way unregistered ones do
+                const bool is_dynamic = inst->IsDynamicId(ent_id);
+                const uint32_t dense = inst->DenseIndex(ent_id);
+
+                if (in_tree_box.has_value() && is_dynamic)
+                    inst->quadtree.Update(ent_id, in_tree_box.value(), inst->boxes_[dense]);
+                else if (in_tree_box.has_value())
+                    inst->quadtree.Erase(ent_id, in_tree_box.value());
+                else if (is_dynamic)
+                    inst->quadtree.Insert(ent_id, inst->boxes_[dense]);
+
+                if (!is_dynamic)
+                    inst->tree_geometry_.erase(ent_id);
+            }
+            inst->pending_changes_.clear();
         }
 
         static std::unique_ptr<SceneVisibility>& GetInstance()
@@ -285,44 +624,759 @@ namespace GiiGa
             else
             {
                 instance_ = std::make_unique<SceneVisibility>();
+                if (!transforms_changed_handle_.isValid())
+                {
+                    transforms_changed_handle_ = TransformSystem::GetInstance().OnTransformsChanged.Register([](const std::span<const uint32_t>& ids)
+                    {
+                        if (instance_) instance_->OnTransformsChanged(ids);
+                    });
+                }
                 return instance_;
             }
         }
 
-        static OrthoTree::index_t Register(std::shared_ptr<IRenderable> renderable, OrthoTree::BoundingBox3D box)
+        // Bound entry follows world matrix of the transform, boxes are refreshed in one batch at TransformSystem::Update.
+        static void BindTransform(VisibilityHandle handle, uint32_t transform_id, const DirectX::BoundingBox& local_box)
+        {
+            auto& inst = GetInstance();
+            inst->DenseIndexChecked(handle);
+
+            auto& bindings = inst->transform_bindings_[transform_id];
+            std::erase_if(bindings, [&](const TransformBinding& binding) { return binding.handle == handle; });
+            bindings.push_back(TransformBinding{handle, local_box});
+
+            const Matrix& world = TransformSystem::GetInstance().GetWorldMatrix(transform_id);
+            DirectX::BoundingBox world_box;
+            local_box.Transform(world_box, world);
+            Update(handle, ToOrthoBox(world_box));
+            inst->UpdateOccluderWorld(handle, world);
+        }
+
+        static void UnbindTransform(VisibilityHandle handle, uint32_t transform_id)
+        {
+            auto& inst = GetInstance();
+            auto it = inst->transform_bindings_.find(transform_id);
+            if (it == inst->transform_bindings_.end()) return;
+
+            std::erase_if(it->second, [&](const TransformBinding& binding) { return binding.handle == handle; });
+            if (it->second.empty())
+                inst->transform_bindings_.erase(it);
+        }
+
+        // Static entries go to bvh built on next Tick, they are expected to move rarely.
+        static VisibilityHandle Register(std::shared_ptr<IRenderable> renderable, OrthoTree::BoundingBox3D box, bool is_static = false)
+        {
+            auto& inst = GetInstance();
+
+            uint32_t index;
+            if (!inst->free_slots_.empty())
+            {
+                index = inst->free_slots_.back();
+                inst->free_slots_.pop_back();
+            }
+            else
+            {
+                index = static_cast<uint32_t>(inst->slots_.size());
+                inst->slots_.emplace_back();
+            }
+
+            auto& slot = inst->slots_[index];
+            slot.dense = static_cast<uint32_t>(inst->renderables_.size());
+            inst->renderables_.push_back(renderable);
+            inst->boxes_.push_back(box);
+            inst->occluders_.emplace_back();
+            inst->culling_storage_.Add(index, box);
+
+            inst->InvalidateFrameCache();
+            inst->MarkMovedForTemporalViews(index);
+            if (is_static)
+                inst->static_rebuild_pending_ = true;
+            else
+                inst->AddDynamic(index, box);
+            return VisibilityHandle{index, slot.generation};
+        }
+
+        // Stale handle (already unregistered) is ignored.
+        static void Unregister(VisibilityHandle handle)
+        {
+            auto& inst = GetInstance();
+            if (!IsAlive(handle))
+                return;
+
+            auto& slot = inst->slots_[handle.index];
+            const uint32_t dense = slot.dense;
+            const uint32_t last = static_cast<uint32_t>(inst->renderables_.size() - 1);
+
+            if (slot.dynamic == VisibilityHandle::InvalidIndex)
+            {
+                inst->InvalidateFrameCache();
+                inst->MarkMovedForTemporalViews(handle.index);
+                inst->static_rebuild_pending_ = true;
+            }
+            else
+            {
+                inst->MarkChanged(handle.index, inst->boxes_[dense]);
+                inst->RemoveDynamic(handle.index);
+            }
+
+            // swap-and-pop, culling storage mirrors the same move
+            if (dense != last)
+            {
+                inst->renderables_[dense] = std::move(inst->renderables_[last]);
+                inst->boxes_[dense] = inst->boxes_[last];
+                inst->occluders_[dense] = inst->occluders_[last];
+                inst->slots_[inst->culling_storage_.Ids()[last]].dense = dense;
+            }
+            inst->renderables_.pop_back();
+            inst->boxes_.pop_back();
+            inst->occluders_.pop_back();
+            inst->culling_storage_.RemoveAt(dense);
+
+            slot.dense = VisibilityHandle::InvalidIndex;
+            ++slot.generation;
+            inst->free_slots_.push_back(handle.index);
+        }
+
+        static void Update(VisibilityHandle handle, OrthoTree::BoundingBox3D newBox)
+        {
+            auto& inst = GetInstance();
+            const uint32_t dense = inst->DenseIndexChecked(handle);
+
+            const uint32_t dynamic = inst->slots_[handle.index].dynamic;
+
+            if (dynamic == VisibilityHandle::InvalidIndex)
+            {
+                inst->InvalidateFrameCache();
+                inst->MarkMovedForTemporalViews(handle.index);
+                inst->static_refit_pending_ = true;
+            }
+            else
+            {
+                inst->MarkChanged(handle.index, inst->boxes_[dense]);
+                inst->dynamic_storage_.SetAt(dynamic, newBox);
+                if (inst->is_tree_built_)
+                    inst->tree_geometry_[handle.index] = newBox;
+            }
+
+            inst->boxes_[dense] = newBox;
+            inst->culling_storage_.SetAt(dense, newBox);
+        }
+
+        // Moves entry between static bvh and dynamic index.
+        static void SetStatic(VisibilityHandle handle, bool is_static)
         {
-            auto ent_id = current_free_id_++;
-            GetInstance()->visibility_to_renderable_[ent_id] = renderable;
-            GetInstance()->visibility_to_geometry_[ent_id] = box;
-            return ent_id;
+            auto& inst = GetInstance();
+            const uint32_t dense = inst->DenseIndexChecked(handle);
+            if (inst->IsStaticId(handle.index) == is_static)
+                return;
+
+            if (is_static)
+            {
+                inst->MarkChanged(handle.index, inst->boxes_[dense]);
+                inst->RemoveDynamic(handle.index);
+            }
+            else
+            {
+                inst->InvalidateFrameCache();
+                inst->MarkMovedForTemporalViews(handle.index);
+                inst->AddDynamic(handle.index, inst->boxes_[dense]);
+            }
+            inst->static_rebuild_pending_ = true;
         }
 
-        static void Unregister(OrthoTree::index_t ent_id)
+        static bool IsAlive(VisibilityHandle handle)
         {
-            GetInstance()->visibility_to_renderable_.erase(ent_id);
-            GetInstance()->visibility_to_geometry_.erase(ent_id);
+            const auto& slots = GetInstance()->slots_;
+            return handle.index < slots.size()
+                && slots[handle.index].generation == handle.generation
+                && slots[handle.index].dense != VisibilityHandle::InvalidIndex;
         }
 
-        static void Update(OrthoTree::index_t ent_id, OrthoTree::BoundingBox3D newBox)
+        // Returns nullptr for stale handle instead of renderable that reused its index.
+        static std::shared_ptr<IRenderable> GetRenderable(VisibilityHandle handle)
         {
-            GetInstance()->visibility_to_geometry_[ent_id] = newBox;
+            if (!IsAlive(handle))
+                return nullptr;
+            auto& inst = GetInstance();
+            return inst->renderables_[inst->slots_[handle.index].dense].lock();
         }
 
     protected:
         static inline std::unique_ptr<SceneVisibility> instance_ = nullptr;
-        static inline OrthoTree::index_t current_free_id_ = 0;
+        static inline EventHandle<std::span<const uint32_t>> transforms_changed_handle_ = EventHandle<std::span<const uint32_t>>::Null();
+
+        struct TransformBinding
+        {
+            VisibilityHandle handle;
+            DirectX::BoundingBox local_box;
+        };
+
+        // transform id -> entries following it, usually one
+        std::unordered_map<uint32_t, std::vector<TransformBinding>> transform_bindings_;
+
+        void OnTransformsChanged(std::span<const uint32_t> ids)
+        {
+            if (transform_bindings_.empty()) return;
 
-        std::unordered_map<OrthoTree::index_t, std::weak_ptr<IRenderable>> visibility_to_renderable_;
-        std::unordered_map<OrthoTree::index_t, OrthoTree::BoundingBox3D> visibility_to_geometry_;
+            auto& transforms = TransformSystem::GetInstance();
+            for (const uint32_t id : ids)
+            {
+                auto it = transform_bindings_.find(id);
+                if (it == transform_bindings_.end() || !transforms.IsAlive(id)) continue;
 
+                const Matrix& world = transforms.GetWorldMatrix(id);
+                for (const auto& binding : it->second)
+                {
+                    if (!IsAlive(binding.handle)) continue;
+                    DirectX::BoundingBox world_box;
+                    binding.local_box.Transform(world_box, world);
+                    Update(binding.handle, ToOrthoBox(world_box));
+                    UpdateOccluderWorld(binding.handle, world);
+                }
+            }
+        }
+
+        void UpdateOccluderWorld(VisibilityHandle handle, const Matrix& world)
+        {
+            if (auto& occluder = occluders_[slots_[handle.index].dense])
+                occluder->world = world;
+        }
+
+        static OrthoTree::BoundingBox3D ToOrthoBox(const DirectX::BoundingBox& box)
+        {
+            return OrthoTree::BoundingBox3D{
+                OrthoTree::Vector3D{box.Center.x - box.Extents.x, box.Center.y - box.Extents.y, box.Center.z - box.Extents.z},
+                OrthoTree::Vector3D{box.Center.x + box.Extents.x, box.Center.y + box.Extents.y, box.Center.z + box.Extents.z}
+            };
+        }
+
+        struct OccluderProxy
+        {
+            DirectX::BoundingBox local_box;
+            Matrix world;
+        };
+
+        struct Slot
+        {
+            // position in packed arrays, InvalidIndex while slot is free
+            uint32_t dense = VisibilityHandle::InvalidIndex;
+            uint32_t generation = 0;
+            // position in dynamic_storage_, InvalidIndex for static entries
+            uint32_t dynamic = VisibilityHandle::InvalidIndex;
+        };
+
+        // sparse slots indexed by handle index, never shrink so indices stay valid
+        std::vector<Slot> slots_;
+        std::vector<uint32_t> free_slots_;
+
+        // packed arrays, element i belongs to index culling_storage_.Ids()[i]
+        std::vector<std::weak_ptr<IRenderable>> renderables_;
+        std::vector<OrthoTree::BoundingBox3D> boxes_;
+        std::vector<std::optional<OccluderProxy>> occluders_;
+
+        // geometry container octree queries read, kept only while tree is built;
+        // unregistered entries stay here until Tick erases them from tree
+        std::unordered_map<OrthoTree::index_t, OrthoTree::BoundingBox3D> tree_geometry_;
+
+        // entries changed since last Tick -> box they have in tree (nullopt if not in tree)
+        std::unordered_map<OrthoTree::index_t, std::optional<OrthoTree::BoundingBox3D>> pending_changes_;
+        bool is_tree_built_ = false;
+
+        // octree holds dynamic entries only
         OrthoTree::OctreeBoxMap quadtree;
+        // all entries, positions match packed arrays
+        CullingStorageSoA culling_storage_;
+
+        // static/dynamic partition used by frustum culling:
+        // static entries in bvh, dynamic ones in octree or dynamic_storage_ depending on backend
+        StaticBVH static_bvh_;
+        bool static_rebuild_pending_ = false;
+        bool static_refit_pending_ = false;
+        CullingStorageSoA dynamic_storage_;
+
+        static std::vector<OrthoTree::index_t> CullSingleView(const DirectX::SimpleMath::Matrix& viewproj, float tolerance = FrustumCullingTolerance)
+        {
+            // Extract frustum planes from the view-projection matrix.
+            auto dxplanes = ExtractFrustumPlanesPointInside(viewproj);
+            auto& inst = GetInstance();
+
+            std::vector<OrthoTree::index_t> ent_ids;
+            inst->static_bvh_.FrustumCulling(dxplanes, tolerance, ent_ids);
+            // bvh keeps entries unregistered or made dynamic since last Tick
+            std::erase_if(ent_ids, [&inst](OrthoTree::index_t ent_id) { return !inst->IsStaticId(ent_id); });
+
+            if (SceneVisibilitySettings::Backend == CullingBackend::LinearSIMD)
+            {
+                inst->dynamic_storage_.FrustumCulling(dxplanes, tolerance, ent_ids);
+                return ent_ids;
+            }
+
+            auto otplanes = std::vector<OrthoTree::Plane3D>(6);
+
+            // Convert DirectX frustum planes to OrthoTree's Plane3D format.
+            for (int i = 0; i < 6; i++)
+            {
+                auto dxnorm = dxplanes[i].Normal();
+
+                if (!(std::abs(dxnorm.LengthSquared() - 1.0) < 0.000001))
+                {
+                    el::Loggers::getLogger(LogWorld)->error("Length %v", dxnorm.LengthSquared());
+                    throw std::runtime_error("Plane Normal Length error");
+                }
+
+                OrthoTree::Vector3D normal = {dxnorm.x, dxnorm.y, dxnorm.z};
+                otplanes[i] = OrthoTree::Plane3D(dxplanes[i].D(), normal);
+            }
+
+            // Perform frustum culling to get IDs of visible entities.
+            auto dynamic_ids = inst->quadtree.FrustumCulling(otplanes, tolerance, inst->tree_geometry_);
+            // tree keeps entries unregistered or made static since last Tick
+            for (auto ent_id : dynamic_ids)
+            {
+                if (inst->IsDynamicId(ent_id))
+                    ent_ids.push_back(ent_id);
+            }
+            return ent_ids;
+        }
+
+        // View culled in previous frames. Entries within TemporalBorderMargin of any plane are in boundary_ids,
+        // entries deeper inside in inner_ids, everything else was further outside than the margin.
+        struct TemporalView
+        {
+            Matrix anchor_viewproj;
+            std::array<Vector3, 8> anchor_corners;
+            uint64_t anchor_frame = 0;
+            uint64_t last_used_frame = 0;
+            std::vector<OrthoTree::index_t> inner_ids;
+            std::vector<OrthoTree::index_t> boundary_ids;
+            // registered or updated since anchor, their classification is stale
+            std::unordered_set<OrthoTree::index_t> moved_ids;
+        };
+
+        std::vector<TemporalView> temporal_views_;
+        TemporalCullingStats temporal_stats_;
+        uint64_t frame_index_ = 0;
+
+        std::vector<OrthoTree::index_t> TemporalCull(const DirectX::SimpleMath::Matrix& viewproj)
+        {
+            // views are not named, cache built for the closest view-projection is picked
+            TemporalView* view = nullptr;
+            float best_delta = SceneVisibilitySettings::TemporalMaxViewDelta;
+            for (auto& temporal_view : temporal_views_)
+            {
+                const float delta = MaxElementDelta(temporal_view.anchor_viewproj, viewproj);
+                if (delta <= best_delta)
+                {
+                    view = &temporal_view;
+                    best_delta = delta;
+                }
+            }
+
+            const auto planes = ExtractFrustumPlanesPointInside(viewproj);
+            const auto corners = ExtractFrustumWorldCorners(viewproj);
+            const bool is_reusable = view
+                && !SceneVisibilitySettings::ForceFullCulling
+                && MaxCornerDisplacement(view->anchor_corners, corners) <= SceneVisibilitySettings::TemporalBorderMargin
+                && frame_index_ - view->anchor_frame < SceneVisibilitySettings::TemporalMaxFrames
+                && static_cast<float>(view->moved_ids.size()) <= SceneVisibilitySettings::TemporalMaxMovedShare * static_cast<float>(boxes_.size());
+
+            if (!view)
+                view = &temporal_views_.emplace_back();
+            view->last_used_frame = frame_index_;
+
+            std::vector<OrthoTree::index_t> ent_ids;
+            if (!is_reusable)
+            {
+                ++temporal_stats_.full_culls;
+                BuildTemporalView(*view, viewproj, corners, planes, ent_ids);
+                return ent_ids;
+            }
+
+            ++temporal_stats_.temporal_hits;
+            ent_ids.reserve(view->inner_ids.size() + view->boundary_ids.size());
+
+            for (auto ent_id : view->inner_ids)
+            {
+                if (DenseIndex(ent_id) != VisibilityHandle::InvalidIndex && !view->moved_ids.contains(ent_id))
+                    ent_ids.push_back(ent_id);
+            }
+
+            for (auto ent_id : view->boundary_ids)
+            {
+                const uint32_t dense = DenseIndex(ent_id);
+                if (dense != VisibilityHandle::InvalidIndex && !view->moved_ids.contains(ent_id)
+                    && culling_storage_.TestSlot(planes, FrustumCullingTolerance, dense))
+                    ent_ids.push_back(ent_id);
+            }
+
+            for (auto ent_id : view->moved_ids)
+            {
+                const uint32_t dense = DenseIndex(ent_id);
+                if (dense != VisibilityHandle::InvalidIndex && culling_storage_.TestSlot(planes, FrustumCullingTolerance, dense))
+                    ent_ids.push_back(ent_id);
+            }
+
+            return ent_ids;
+        }
+
+        void BuildTemporalView(TemporalView& view, const DirectX::SimpleMath::Matrix& viewproj, const std::array<Vector3, 8>& corners,
+                               const std::vector<Plane>& planes, std::vector<OrthoTree::index_t>& visible_ids)
+        {
+            const float margin = SceneVisibilitySettings::TemporalBorderMargin;
+
+            view.anchor_viewproj = viewproj;
+            view.anchor_corners = corners;
+            view.anchor_frame = frame_index_;
+            view.inner_ids.clear();
+            view.boundary_ids.clear();
+            view.moved_ids.clear();
+
+            // everything not further than margin outside, then split by distance inside
+            for (auto ent_id : CullSingleView(viewproj, FrustumCullingTolerance + margin))
+            {
+                const uint32_t dense = slots_[ent_id].dense;
+                if (culling_storage_.TestSlot(planes, -margin, dense))
+                {
+                    view.inner_ids.push_back(ent_id);
+                    visible_ids.push_back(ent_id);
+                }
+                else
+                {
+                    view.boundary_ids.push_back(ent_id);
+                    if (culling_storage_.TestSlot(planes, FrustumCullingTolerance, dense))
+                        visible_ids.push_back(ent_id);
+                }
+            }
+        }
+
+        void MarkMovedForTemporalViews(OrthoTree::index_t ent_id)
+        {
+            for (auto& view : temporal_views_)
+                view.moved_ids.insert(ent_id);
+        }
+
+        // Frustum is convex hull of its corners: when no corner moved further than margin,
+        // every point of one frustum is within margin of the other, so only border band needs re-testing.
+        static float MaxCornerDisplacement(const std::array<Vector3, 8>& lhs, const std::array<Vector3, 8>& rhs)
+        {
+            float max_squared = 0.0f;
+            for (size_t i = 0; i < lhs.size(); ++i)
+                max_squared = std::max(max_squared, Vector3::DistanceSquared(lhs[i], rhs[i]));
+            return std::sqrt(max_squared);
+        }
+
+        static float MaxElementDelta(const DirectX::SimpleMath::Matrix& lhs, const DirectX::SimpleMath::Matrix& rhs)
+        {
+            float delta = 0.0f;
+            for (int row = 0; row < 4; ++row)
+            {
+                for (int col = 0; col < 4; ++col)
+                    delta = std::max(delta, std::abs(lhs.m[row][col] - rhs.m[row][col]));
+            }
+            return delta;
+        }
+
+        void OcclusionCulling(const DirectX::SimpleMath::Matrix& viewproj, std::vector<OrthoTree::index_t>& ent_ids, OcclusionStats& stats)
+        {
+            occlusion_.Resize(SceneVisibilitySettings::OcclusionBufferWidth, SceneVisibilitySettings::OcclusionBufferHeight);
+            occlusion_.Begin(viewproj);
+
+            occluder_flags_.assign(ent_ids.size(), false);
+            for (size_t i = 0; i < ent_ids.size(); ++i)
+            {
+                if (const auto& occluder = occluders_[slots_[ent_ids[i]].dense])
+                {
+                    occlusion_.RasterizeOccluder(occluder->local_box, occluder->world);
+                    occluder_flags_[i] = true;
+                    ++stats.occluders_rasterized;
+                }
+            }
+
+            if (stats.occluders_rasterized == 0)
+                return;
+
+            occlusion_.End();
+
+            size_t kept = 0;
+            for (size_t i = 0; i < ent_ids.size(); ++i)
+            {
+                if (!occluder_flags_[i])
+                {
+                    ++stats.occludees_tested;
+                    if (occlusion_.IsOccluded(boxes_[slots_[ent_ids[i]].dense]))
+                    {
+                        ++stats.occludees_culled;
+                        continue;
+                    }
+                }
+                ent_ids[kept++] = ent_ids[i];
+            }
+            ent_ids.resize(kept);
+        }
+
+        struct CachedViewCulling
+        {
+            Matrix viewproj;
+            std::shared_ptr<const std::vector<OrthoTree::index_t>> ids;
+            OcclusionStats occlusion_stats;
+        };
+
+        const CachedViewCulling* FindCachedView(const DirectX::SimpleMath::Matrix& viewproj) const
+        {
+            for (const auto& cached : frame_single_view_cache_)
+            {
+                if (cached.viewproj == viewproj)
+                    return &cached;
+            }
+            return nullptr;
+        }
+
+        SoftwareOcclusion occlusion_;
+        std::vector<bool> occluder_flags_;
+
+        // culling results computed this frame, keyed by view-projection matrices
+        // results are shared with callers, clearing the cache does not invalidate ids they still hold
+        std::vector<CachedViewCulling> frame_single_view_cache_;
+        std::vector<std::pair<std::vector<Matrix>, std::shared_ptr<const MultiViewCullingResult>>> frame_multi_view_cache_;
+
+        void InvalidateFrameCache()
+        {
+            frame_single_view_cache_.clear();
+            frame_multi_view_cache_.clear();
+        }
+
+        // Larger side of box's projected bounds in pixels, infinity when box reaches behind camera.
+        static float ProjectedPixelSize(const OrthoTree::BoundingBox3D& box, const DirectX::SimpleMath::Matrix& viewproj,
+                                        const DirectX::SimpleMath::Vector2& screen_size)
+        {
+            float min_x = std::numeric_limits<float>::max(), min_y = std::numeric_limits<float>::max();
+            float max_x = -std::numeric_limits<float>::max(), max_y = -std::numeric_limits<float>::max();
+            for (uint32_t i = 0; i < 8; ++i)
+            {
+                const Vector4 corner{
+                    static_cast<float>((i & 4) ? box.Max[0] : box.Min[0]),
+                    static_cast<float>((i & 2) ? box.Max[1] : box.Min[1]),
+                    static_cast<float>((i & 1) ? box.Max[2] : box.Min[2]),
+                    1.0f
+                };
+                const Vector4 clip = Vector4::Transform(corner, viewproj);
+                if (clip.w <= 0.0f)
+                    return std::numeric_limits<float>::infinity();
+
+                min_x = std::min(min_x, clip.x / clip.w);
+                min_y = std::min(min_y, clip.y / clip.w);
+                max_x = std::max(max_x, clip.x / clip.w);
+                max_y = std::max(max_y, clip.y / clip.w);
+            }
+            // ndc spans 2 units across the screen
+            return std::max((max_x - min_x) * 0.5f * screen_size.x, (max_y - min_y) * 0.5f * screen_size.y);
+        }
+
+        VisibilityHandle HandleOfId(OrthoTree::index_t ent_id) const
+        {
+            const auto index = static_cast<uint32_t>(ent_id);
+            return VisibilityHandle{index, slots_[index].generation};
+        }
+
+        // 1 / direction per axis after normalization, kept finite so slab tests never compute 0 * inf
+        static bool InverseDirection(DirectX::SimpleMath::Vector3 direction, DirectX::SimpleMath::Vector3& inv_direction)
+        {
+            const float length_sq = direction.LengthSquared();
+            if (!(length_sq > 0.0f) || !std::isfinite(length_sq))
+                return false;
+
+            direction /= std::sqrt(length_sq);
+            constexpr float MaxInverse = 1e30f;
+            auto inverse = [](float d) { return std::abs(d) > 1.0f / MaxInverse ? 1.0f / d : std::copysign(MaxInverse, d); };
+            inv_direction = Vector3{inverse(direction.x), inverse(direction.y), inverse(direction.z)};
+            return true;
+        }
+
+        // Max-heap on distance over result[0, written), keeps the nearest result.size() hits.
+        // Returns distance a new hit has to beat, bound while result is not full.
+        template <typename Hit>
+        static float PushNearest(std::span<Hit> result, size_t& written, const Hit& hit, float bound)
+        {
+            auto further = [](const Hit& lhs, const Hit& rhs) { return lhs.distance < rhs.distance; };
+            if (written < result.size())
+            {
+                result[written++] = hit;
+                std::push_heap(result.begin(), result.begin() + written, further);
+            }
+            else if (hit.distance < result.front().distance)
+            {
+                std::pop_heap(result.begin(), result.begin() + written, further);
+                result[written - 1] = hit;
+                std::push_heap(result.begin(), result.begin() + written, further);
+            }
+            return written < result.size() ? bound : result.front().distance;
+        }
+
+        template <typename Hit>
+        static void SortNearest(std::span<Hit> result, size_t written)
+        {
+            std::sort_heap(result.begin(), result.begin() + written, [](const Hit& lhs, const Hit& rhs) { return lhs.distance < rhs.distance; });
+        }
+
+        // bvh matches registered static entries only after Tick applied static changes
+        bool IsStaticBVHCurrent() const
+        {
+            return !static_rebuild_pending_ && !static_refit_pending_;
+        }
+
+        // fn(ent_id, t) returns new max_t, dynamic entries go first so they can tighten the bvh search
+        template <typename Fn>
+        void QueryRayHits(const DirectX::SimpleMath::Vector3& origin, const DirectX::SimpleMath::Vector3& inv_direction, float max_t, Fn&& fn) const
+        {
+            const auto& storage = IsStaticBVHCurrent() ? dynamic_storage_ : culling_storage_;
+            storage.ForEachRayHit(origin, inv_direction, max_t, [&](size_t slot, float t)
+            {
+                if (t <= max_t)
+                    max_t = fn(storage.Ids()[slot], t);
+            });
+
+            if (IsStaticBVHCurrent())
+                static_bvh_.ForEachRayHit(origin, inv_direction, max_t, fn);
+        }
+
+        // fn(ent_id, squared distance) returns new bound
+        template <typename Fn>
+        void QueryNearest(const DirectX::SimpleMath::Vector3& point, Fn&& fn) const
+        {
+            float bound = std::numeric_limits<float>::max();
+            const auto& storage = IsStaticBVHCurrent() ? dynamic_storage_ : culling_storage_;
+            storage.ForEachDistanceSq(point, [&](size_t slot, float distance_sq)
+            {
+                if (distance_sq <= bound)
+                    bound = fn(storage.Ids()[slot], distance_sq);
+            });
+
+            if (IsStaticBVHCurrent())
+                static_bvh_.ForEachNearest(point, bound, fn);
+        }
+
+        template <typename Fn>
+        void QueryOverlapBox(const DirectX::SimpleMath::Vector3& min, const DirectX::SimpleMath::Vector3& max, Fn&& fn) const
+        {
+            const auto& storage = IsStaticBVHCurrent() ? dynamic_storage_ : culling_storage_;
+            storage.ForEachOverlapBox(min, max, [&](size_t slot) { fn(storage.Ids()[slot]); });
+
+            if (IsStaticBVHCurrent())
+                static_bvh_.ForEachOverlapBox(min, max, fn);
+        }
+
+        template <typename Fn>
+        void QueryOverlapSphere(const DirectX::SimpleMath::Vector3& center, float radius, Fn&& fn) const
+        {
+            const auto& storage = IsStaticBVHCurrent() ? dynamic_storage_ : culling_storage_;
+            storage.ForEachOverlapSphere(center, radius, [&](size_t slot) { fn(storage.Ids()[slot]); });
+
+            if (IsStaticBVHCurrent())
+                static_bvh_.ForEachOverlapSphere(center, radius, fn);
+        }
+
+        bool IsStaticId(OrthoTree::index_t ent_id) const
+        {
+            return DenseIndex(ent_id) != VisibilityHandle::InvalidIndex && slots_[ent_id].dynamic == VisibilityHandle::InvalidIndex;
+        }
+
+        bool IsDynamicId(OrthoTree::index_t ent_id) const
+        {
+            return ent_id < slots_.size() && slots_[ent_id].dynamic != VisibilityHandle::InvalidIndex;
+        }
+
+        void AddDynamic(uint32_t index, const OrthoTree::BoundingBox3D& box)
+        {
+            slots_[index].dynamic = static_cast<uint32_t>(dynamic_storage_.Size());
+            dynamic_storage_.Add(index, box);
+            if (is_tree_built_)
+            {
+                tree_geometry_[index] = box;
+                // entry is not in tree yet unless it left it this frame, nothing to remember
+                pending_changes_.try_emplace(index, std::nullopt);
+            }
+        }
+
+        void RemoveDynamic(uint32_t index)
+        {
+            const uint32_t dynamic = slots_[index].dynamic;
+            const auto last = dynamic_storage_.Size() - 1;
+            if (dynamic != last)
+                slots_[dynamic_storage_.Ids()[last]].dynamic = dynamic;
+            dynamic_storage_.RemoveAt(dynamic);
+            slots_[index].dynamic = VisibilityHandle::InvalidIndex;
+        }
+
+        void RebuildStaticBVH()
+        {
+            std::vector<StaticBVH::Item> items;
+            items.reserve(boxes_.size() - dynamic_storage_.Size());
+            for (size_t dense = 0; dense < boxes_.size(); ++dense)
+            {
+                const auto ent_id = culling_storage_.Ids()[dense];
+                if (slots_[ent_id].dynamic == VisibilityHandle::InvalidIndex)
+                    items.push_back(StaticBVH::Item{ent_id, boxes_[dense]});
+            }
+            static_bvh_.Build(std::move(items));
+        }
+
+        // Position of live entry in packed arrays, InvalidIndex if ent_id is free.
+        uint32_t DenseIndex(OrthoTree::index_t ent_id) const
+        {
+            return ent_id < slots_.size() ? slots_[ent_id].dense : VisibilityHandle::InvalidIndex;
+        }
+
+        uint32_t DenseIndexChecked(VisibilityHandle handle) const
+        {
+            if (!IsAlive(handle))
+                throw std::runtime_error("SceneVisibility: stale visibility handle");
+            return slots_[handle.index].dense;
+        }
+
+        void MarkChanged(OrthoTree::index_t ent_id, const OrthoTree::BoundingBox3D& current_box)
+        {
+            InvalidateFrameCache();
+            MarkMovedForTemporalViews(ent_id);
+            // only first change in frame knows where entry sits in tree
+            if (is_tree_built_)
+                pending_changes_.try_emplace(ent_id, current_box);
+        }
+
+        void RebuildTree()
+        {
+            tree_geometry_.clear();
+            tree_geometry_.reserve(dynamic_storage_.Size());
+            for (auto ent_id : dynamic_storage_.Ids())
+                tree_geometry_.emplace(ent_id, boxes_[slots_[ent_id].dense]);
+
+            quadtree = OrthoTree::OctreeBoxMap
+            {
+                tree_geometry_,
+                SceneVisibilitySettings::OctreeMaxDepth,
+                OrthoTree::BoundingBox3D{
+                    {
+                        -std::numeric_limits<float>::max(),
+                        -std::numeric_limits<float>::max(),
+                        -std::numeric_limits<float>::max()
+                    },
+                    {
+                        std::numeric_limits<float>::max(),
+                        std::numeric_limits<float>::max(),
+                        std::numeric_limits<float>::max()
+                    }
+                },
+                SceneVisibilitySettings::OctreeMaxElementsInNode
+            };
+            pending_changes_.clear();
+            is_tree_built_ = true;
+        }
     };
 
     // todo: create DirectX::Math to OrthoTree conversions or adapter
     class VisibilityEntry
     {
     public:
-        static std::unique_ptr<VisibilityEntry> Register(std::shared_ptr<IRenderable> renderable, DirectX::BoundingBox aabb = DirectX::BoundingBox())
+        static std::unique_ptr<VisibilityEntry> Register(std::shared_ptr<IRenderable> renderable, DirectX::BoundingBox aabb = DirectX::BoundingBox(), bool is_static = false)
         {
             OrthoTree::Vector3D min{
                 aabb.Center.x - aabb.Extents.x,
@@ -336,12 +1390,24 @@ namespace GiiGa
                 aabb.Center.z + aabb.Extents.z
             };
 
-            return std::unique_ptr<VisibilityEntry>(new VisibilityEntry(SceneVisibility::Register(renderable, OrthoTree::BoundingBox3D{min, max})));
+            return std::unique_ptr<VisibilityEntry>(new VisibilityEntry(SceneVisibility::Register(renderable, OrthoTree::BoundingBox3D{min, max}, is_static)));
         }
 
         void Unregister()
         {
-            SceneVisibility::Unregister(entity_index_);
+            if (transform_id_ != TransformSystem::InvalidId)
+                SceneVisibility::UnbindTransform(handle_, transform_id_);
+            transform_id_ = TransformSystem::InvalidId;
+            SceneVisibility::Unregister(handle_);
+        }
+
+        // box follows the transform, local_box is in its space
+        void BindTransform(uint32_t transform_id, const DirectX::BoundingBox& local_box)
+        {
+            if (transform_id_ != TransformSystem::InvalidId)
+                SceneVisibility::UnbindTransform(handle_, transform_id_);
+            transform_id_ = transform_id;
+            SceneVisibility::BindTransform(handle_, transform_id, local_box);
         }
 
         ~VisibilityEntry()
@@ -363,15 +1429,30 @@ namespace GiiGa
                 aabb.Center.z + aabb.Extents.z
             };
 
-            SceneVisibility::Update(entity_index_, OrthoTree::BoundingBox3D{min, max});
+            SceneVisibility::Update(handle_, OrthoTree::BoundingBox3D{min, max});
+        }
+
+        // local_proxy is in space of bound transform
+        void SetOccluder(std::optional<DirectX::BoundingBox> local_proxy)
+        {
+            const Matrix world = transform_id_ != TransformSystem::InvalidId
+                                     ? TransformSystem::GetInstance().GetWorldMatrix(transform_id_)
+                                     : Matrix::Identity;
+            SceneVisibility::SetOccluder(handle_, local_proxy, world);
+        }
+
+        void SetStatic(bool is_static)
+        {
+            SceneVisibility::SetStatic(handle_, is_static);
         }
 
     private:
-        VisibilityEntry(OrthoTree::index_t id):
-            entity_index_(id)
+        VisibilityEntry(VisibilityHandle handle):
+            handle_(handle)
         {
         }
 
-        OrthoTree::index_t entity_index_;
+        VisibilityHandle handle_;
+        uint32_t transform_id_ = TransformSystem::InvalidId;
     };
 }
@@ -0,0 +1,306 @@
+#pragma once
+
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include<directxtk12/SimpleMath.h>
+#include<DirectXCollision.h>
+#include<Octree/octree.h>
+#include<immintrin.h>
+
+#include<array>
+#include<vector>
+#include<limits>
+#include<algorithm>
+
+namespace GiiGa
+{
+    struct OcclusionStats
+    {
+        uint32_t occluders_rasterized = 0;
+        uint32_t occludees_tested = 0;
+        uint32_t occludees_culled = 0;
+    };
+
+    /*
+     * Low resolution CPU depth buffer with hierarchical-Z on top of it.
+     * Occluders are rasterized as author-supplied proxy boxes, a proxy has to lie
+     * inside the solid part of its mesh, otherwise objects seen past it get culled.
+     * Depth follows D3D convention: 0 near, 1 far, buffer keeps nearest depth.
+     */
+    class SoftwareOcclusion
+    {
+    public:
+        void Resize(uint32_t width, uint32_t height)
+        {
+            // rasterizer works on 4 pixels at once
+            width = std::max<uint32_t>(4, (width + 3) & ~3u);
+            height = std::max<uint32_t>(1, height);
+
+            if (width == width_ && height == height_)
+                return;
+
+            width_ = width;
+            height_ = height;
+
+            hiz_.clear();
+            uint32_t level_width = width_;
+            uint32_t level_height = height_;
+            while (true)
+            {
+                hiz_.push_back(HiZLevel{level_width, level_height, std::vector<float>(level_width * level_height)});
+                if (level_width == 1 && level_height == 1)
+                    break;
+                level_width = std::max<uint32_t>(1, (level_width + 1) / 2);
+                level_height = std::max<uint32_t>(1, (level_height + 1) / 2);
+            }
+        }
+
+        void Begin(const DirectX::SimpleMath::Matrix& viewproj)
+        {
+            viewproj_ = viewproj;
+            std::fill(hiz_[0].depth.begin(), hiz_[0].depth.end(), 1.0f);
+        }
+
+        // local_box is transformed by world as an oriented box, rotated proxies stay tight
+        void RasterizeOccluder(const DirectX::BoundingBox& local_box, const DirectX::SimpleMath::Matrix& world)
+        {
+            const DirectX::SimpleMath::Matrix world_viewproj = world * viewproj_;
+            std::array<DirectX::SimpleMath::Vector4, 8> clip;
+            for (uint32_t i = 0; i < 8; ++i)
+            {
+                const DirectX::SimpleMath::Vector4 corner{
+                    local_box.Center.x + ((i & 4) ? local_box.Extents.x : -local_box.Extents.x),
+                    local_box.Center.y + ((i & 2) ? local_box.Extents.y : -local_box.Extents.y),
+                    local_box.Center.z + ((i & 1) ? local_box.Extents.z : -local_box.Extents.z),
+                    1.0f
+                };
+                clip[i] = DirectX::SimpleMath::Vector4::Transform(corner, world_viewproj);
+            }
+
+            // triangles crossing near plane would need clipping, dropping them keeps the buffer conservative
+            for (const auto& corner : clip)
+            {
+                if (corner.w <= NearW)
+                    return;
+            }
+
+            std::array<DirectX::SimpleMath::Vector3, 8> screen;
+            for (size_t i = 0; i < clip.size(); ++i)
+                screen[i] = ToScreen(clip[i]);
+
+            for (const auto& tri : BoxTriangles)
+                RasterizeTriangle(screen[tri[0]], screen[tri[1]], screen[tri[2]]);
+        }
+
+        // Call after all occluders are rasterized and before IsOccluded.
+        void End()
+        {
+            for (size_t level = 1; level < hiz_.size(); ++level)
+            {
+                const auto& src = hiz_[level - 1];
+                auto& dst = hiz_[level];
+                for (uint32_t y = 0; y < dst.height; ++y)
+                {
+                    const uint32_t y0 = std::min(y * 2, src.height - 1);
+                    const uint32_t y1 = std::min(y * 2 + 1, src.height - 1);
+                    for (uint32_t x = 0; x < dst.width; ++x)
+                    {
+                        const uint32_t x0 = std::min(x * 2, src.width - 1);
+                        const uint32_t x1 = std::min(x * 2 + 1, src.width - 1);
+                        dst.depth[y * dst.width + x] = std::max(
+                            std::max(src.depth[y0 * src.width + x0], src.depth[y0 * src.width + x1]),
+                            std::max(src.depth[y1 * src.width + x0], src.depth[y1 * src.width + x1]));
+                    }
+                }
+            }
+        }
+
+        bool IsOccluded(const OrthoTree::BoundingBox3D& box) const
+        {
+            std::array<DirectX::SimpleMath::Vector4, 8> clip;
+            ProjectCorners(box, clip);
+
+            float min_x = std::numeric_limits<float>::max(), min_y = std::numeric_limits<float>::max();
+            float max_x = -std::numeric_limits<float>::max(), max_y = -std::numeric_limits<float>::max();
+            float min_z = std::numeric_limits<float>::max();
+
+            for (const auto& corner : clip)
+            {
+                // box touches camera plane, can not be hidden
+                if (corner.w <= NearW)
+                    return false;
+
+                const auto screen = ToScreen(corner);
+                min_x = std::min(min_x, screen.x);
+                min_y = std::min(min_y, screen.y);
+                max_x = std::max(max_x, screen.x);
+                max_y = std::max(max_y, screen.y);
+                min_z = std::min(min_z, screen.z);
+            }
+
+            const float fwidth = static_cast<float>(width_);
+            const float fheight = static_cast<float>(height_);
+            if (max_x < 0 || max_y < 0 || min_x >= fwidth || min_y >= fheight)
+                return false;
+
+            auto x0 = static_cast<uint32_t>(std::clamp(min_x, 0.0f, fwidth - 1));
+            auto y0 = static_cast<uint32_t>(std::clamp(min_y, 0.0f, fheight - 1));
+            auto x1 = static_cast<uint32_t>(std::clamp(max_x, 0.0f, fwidth - 1));
+            auto y1 = static_cast<uint32_t>(std::clamp(max_y, 0.0f, fheight - 1));
+
+            // pick level where rect covers at most 4x4 texels
+            size_t level = 0;
+            while (level + 1 < hiz_.size() && std::max(x1 - x0, y1 - y0) >= 4)
+            {
+                x0 /= 2;
+                y0 /= 2;
+                x1 /= 2;
+                y1 /= 2;
+                ++level;
+            }
+
+            const auto& hiz = hiz_[level];
+            for (uint32_t y = y0; y <= y1; ++y)
+            {
+                for (uint32_t x = x0; x <= x1; ++x)
+                {
+                    if (hiz.depth[y * hiz.width + x] >= min_z)
+                        return false;
+                }
+            }
+            return true;
+        }
+
+    private:
+        struct HiZLevel
+        {
+            uint32_t width;
+            uint32_t height;
+            std::vector<float> depth;
+        };
+
+        static constexpr float NearW = 1e-4f;
+
+        static constexpr std::array<std::array<uint8_t, 3>, 12> BoxTriangles{
+            {
+                {0, 1, 3}, {0, 3, 2}, // -x
+                {4, 6, 7}, {4, 7, 5}, // +x
+                {0, 4, 5}, {0, 5, 1}, // -y
+                {2, 3, 7}, {2, 7, 6}, // +y
+                {0, 2, 6}, {0, 6, 4}, // -z
+                {1, 5, 7}, {1, 7, 3}, // +z
+            }
+        };
+
+        uint32_t width_ = 0;
+        uint32_t height_ = 0;
+        DirectX::SimpleMath::Matrix viewproj_;
+        // hiz_[0] is the depth buffer itself, next levels keep farthest depth of 2x2 texels
+        std::vector<HiZLevel> hiz_;
+
+        // corner i has bit 2 - x, bit 1 - y, bit 0 - z set to max
+        void ProjectCorners(const OrthoTree::BoundingBox3D& box, std::array<DirectX::SimpleMath::Vector4, 8>& clip) const
+        {
+            for (uint32_t i = 0; i < 8; ++i)
+            {
+                const DirectX::SimpleMath::Vector4 corner{
+                    static_cast<float>((i & 4) ? box.Max[0] : box.Min[0]),
+                    static_cast<float>((i & 2) ? box.Max[1] : box.Min[1]),
+                    static_cast<float>((i & 1) ? box.Max[2] : box.Min[2]),
+                    1.0f
+                };
+                clip[i] = DirectX::SimpleMath::Vector4::Transform(corner, viewproj_);
+            }
+        }
+
+        DirectX::SimpleMath::Vector3 ToScreen(const DirectX::SimpleMath::Vector4& clip) const
+        {
+            const float inv_w = 1.0f / clip.w;
+            return {
+                (clip.x * inv_w * 0.5f + 0.5f) * static_cast<float>(width_),
+                (0.5f - clip.y * inv_w * 0.5f) * static_cast<float>(height_),
+                clip.z * inv_w
+            };
+        }
+
+        static float Edge(const DirectX::SimpleMath::Vector3& a, const DirectX::SimpleMath::Vector3& b, float px, float py)
+        {
+            return (b.x - a.x) * (py - a.y) - (b.y - a.y) * (px - a.x);
+        }
+
+        void RasterizeTriangle(DirectX::SimpleMath::Vector3 v0, DirectX::SimpleMath::Vector3 v1, DirectX::SimpleMath::Vector3 v2)
+        {
+            float area = Edge(v0, v1, v2.x, v2.y);
+            if (area == 0.0f)
+                return;
+            // box faces are rasterized from both sides
+            if (area < 0.0f)
+            {
+                std::swap(v1, v2);
+                area = -area;
+            }
+
+            const float fwidth = static_cast<float>(width_);
+            const float fheight = static_cast<float>(height_);
+            const float min_xf = std::max(0.0f, std::min({v0.x, v1.x, v2.x}));
+            const float min_yf = std::max(0.0f, std::min({v0.y, v1.y, v2.y}));
+            const float max_xf = std::min(fwidth - 1, std::max({v0.x, v1.x, v2.x}));
+            const float max_yf = std::min(fheight - 1, std::max({v0.y, v1.y, v2.y}));
+            if (min_xf > max_xf || min_yf > max_yf)
+                return;
+
+            const uint32_t min_x = static_cast<uint32_t>(min_xf) & ~3u;
+            const uint32_t min_y = static_cast<uint32_t>(min_yf);
+            const uint32_t max_x = static_cast<uint32_t>(max_xf);
+            const uint32_t max_y = static_cast<uint32_t>(max_yf);
+
+            const float inv_area = 1.0f / area;
+            auto& depth = hiz_[0].depth;
+
+            // edge function is linear: e(x + 1) = e(x) + step
+            const __m128 step0 = _mm_set1_ps(-(v2.y - v1.y));
+            const __m128 step1 = _mm_set1_ps(-(v0.y - v2.y));
+            const __m128 step2 = _mm_set1_ps(-(v1.y - v0.y));
+            const __m128 lane_offsets = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+            const __m128 four = _mm_set1_ps(4.0f);
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 z0 = _mm_set1_ps(v0.z * inv_area);
+            const __m128 z1 = _mm_set1_ps(v1.z * inv_area);
+            const __m128 z2 = _mm_set1_ps(v2.z * inv_area);
+
+            for (uint32_t y = min_y; y <= max_y; ++y)
+            {
+                const float py = static_cast<float>(y) + 0.5f;
+                const float px = static_cast<float>(min_x) + 0.5f;
+
+                __m128 w0 = _mm_add_ps(_mm_set1_ps(Edge(v1, v2, px, py)), _mm_mul_ps(step0, lane_offsets));
+                __m128 w1 = _mm_add_ps(_mm_set1_ps(Edge(v2, v0, px, py)), _mm_mul_ps(step1, lane_offsets));
+                __m128 w2 = _mm_add_ps(_mm_set1_ps(Edge(v0, v1, px, py)), _mm_mul_ps(step2, lane_offsets));
+
+                const __m128 step0_x4 = _mm_mul_ps(step0, four);
+                const __m128 step1_x4 = _mm_mul_ps(step1, four);
+                const __m128 step2_x4 = _mm_mul_ps(step2, four);
+
+                float* row = depth.data() + static_cast<size_t>(y) * width_;
+                for (uint32_t x = min_x; x <= max_x; x += 4)
+                {
+                    const __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(w0, zero), _mm_cmpge_ps(w1, zero)), _mm_cmpge_ps(w2, zero));
+
+                    if (_mm_movemask_ps(inside))
+                    {
+                        const __m128 z = _mm_add_ps(_mm_add_ps(_mm_mul_ps(w0, z0), _mm_mul_ps(w1, z1)), _mm_mul_ps(w2, z2));
+                        const __m128 old_z = _mm_loadu_ps(row + x);
+                        const __m128 new_z = _mm_min_ps(old_z, z);
+                        _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, new_z), _mm_andnot_ps(inside, old_z)));
+                    }
+
+                    w0 = _mm_add_ps(w0, step0_x4);
+                    w1 = _mm_add_ps(w1, step1_x4);
+                    w2 = _mm_add_ps(w2, step2_x4);
+                }
+            }
+        }
+    };
+}
@@ -0,0 +1,577 @@
+#pragma once
+
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include<directxtk12/SimpleMath.h>
+#include<Octree/octree.h>
+#include<immintrin.h>
+
+#include<array>
+#include<span>
+#include<vector>
+#include<limits>
+#include<algorithm>
+
+namespace GiiGa
+{
+    /*
+     * Bounding volume hierarchy for entries that do not move: built with binned SAH,
+     * stored flattened in depth-first order, so left child directly follows its parent
+     * and items of any subtree form a contiguous range.
+     * Box changes without membership changes are handled by Refit, which keeps topology.
+     */
+    class StaticBVH
+    {
+    public:
+        static constexpr uint32_t MaxLeafSize = 4;
+        static constexpr uint32_t MaxDepth = 64;
+        static constexpr uint32_t BinCount = 16;
+
+        struct Item
+        {
+            OrthoTree::index_t id;
+            OrthoTree::BoundingBox3D box;
+        };
+
+        void Clear()
+        {
+            nodes_.clear();
+            items_.clear();
+        }
+
+        bool Empty() const
+        {
+            return items_.empty();
+        }
+
+        void Build(std::vector<Item> items)
+        {
+            nodes_.clear();
+            items_ = std::move(items);
+            if (items_.empty())
+                return;
+
+            nodes_.reserve(items_.size() * 2);
+            BuildNode(0, static_cast<uint32_t>(items_.size()), 0);
+        }
+
+        // Reads new boxes through box_of(id) and recomputes node bounds bottom-up.
+        template <typename BoxOf>
+        void Refit(BoxOf&& box_of)
+        {
+            for (auto& item : items_)
+                item.box = box_of(item.id);
+
+            // children always have bigger indices than their parent
+            for (size_t i = nodes_.size(); i-- > 0;)
+            {
+                auto& node = nodes_[i];
+                if (node.IsLeaf())
+                    SetBounds(node, node.first_item, node.item_count);
+                else
+                    SetBounds(node, nodes_[i + 1], nodes_[node.right_child]);
+            }
+        }
+
+        // Same plane convention as CullingStorageSoA::FrustumCulling.
+        void FrustumCulling(const std::vector<DirectX::SimpleMath::Plane>& planes, float tolerance, std::vector<OrthoTree::index_t>& result) const
+        {
+            if (nodes_.empty())
+                return;
+
+            std::array<uint32_t, MaxDepth + 2> stack;
+            uint32_t stack_size = 0;
+            stack[stack_size++] = 0;
+
+            while (stack_size)
+            {
+                const auto& node = nodes_[stack[--stack_size]];
+
+                bool is_inside;
+                if (!IntersectsFrustum(node.min, node.max, planes, tolerance, is_inside))
+                    continue;
+
+                if (is_inside || node.IsLeaf())
+                {
+                    for (uint32_t i = node.first_item; i < node.first_item + node.item_count; ++i)
+                    {
+                        if (is_inside || IntersectsFrustum(items_[i].box, planes, tolerance))
+                            result.push_back(items_[i].id);
+                    }
+                    continue;
+                }
+
+                stack[stack_size++] = node.right_child;
+                stack[stack_size++] = static_cast<uint32_t>(&node - nodes_.data()) + 1;
+            }
+        }
+
+        // Same output as CullingStorageSoA::MultiFrustumCulling, subtrees are dropped per view.
+        void MultiFrustumCulling(const std::vector<std::vector<DirectX::SimpleMath::Plane>>& views_planes, float tolerance,
+                                 std::vector<OrthoTree::index_t>& result_ids, std::vector<uint64_t>& result_masks) const
+        {
+            if (nodes_.empty() || views_planes.empty())
+                return;
+
+            struct StackItem
+            {
+                uint32_t node;
+                // views node may be visible in / views containing node completely
+                uint64_t active;
+                uint64_t inside;
+            };
+
+            std::array<StackItem, MaxDepth + 2> stack;
+            uint32_t stack_size = 0;
+            const uint64_t all_views = views_planes.size() == 64 ? ~uint64_t{0} : (uint64_t{1} << views_planes.size()) - 1;
+            stack[stack_size++] = StackItem{0, all_views, 0};
+
+            while (stack_size)
+            {
+                auto [node_index, active, inside] = stack[--stack_size];
+                const auto& node = nodes_[node_index];
+
+                for (uint64_t undecided = active & ~inside; undecided; undecided &= undecided - 1)
+                {
+                    const uint64_t view_bit = undecided & (~undecided + 1);
+                    const size_t view = CountTrailingZeros(view_bit);
+
+                    bool is_inside;
+                    if (!IntersectsFrustum(node.min, node.max, views_planes[view], tolerance, is_inside))
+                        active &= ~view_bit;
+                    else if (is_inside)
+                        inside |= view_bit;
+                }
+
+                if (!active)
+                    continue;
+
+                if (active == inside || node.IsLeaf())
+                {
+                    for (uint32_t i = node.first_item; i < node.first_item + node.item_count; ++i)
+                    {
+                        uint64_t mask = inside;
+                        for (uint64_t undecided = active & ~inside; undecided; undecided &= undecided - 1)
+                        {
+                            const uint64_t view_bit = undecided & (~undecided + 1);
+                            if (IntersectsFrustum(items_[i].box, views_planes[CountTrailingZeros(view_bit)], tolerance))
+                                mask |= view_bit;
+                        }
+
+                        if (mask)
+                        {
+                            result_ids.push_back(items_[i].id);
+                            result_masks.push_back(mask);
+                        }
+                    }
+                    continue;
+                }
+
+                stack[stack_size++] = StackItem{node.right_child, active, inside};
+                stack[stack_size++] = StackItem{node_index + 1, active, inside};
+            }
+        }
+
+        // Spatial queries below mirror CullingStorageSoA ones but pass entry ids, they never allocate.
+
+        // fn(id) for every box intersecting [min, max].
+        template <typename Fn>
+        void ForEachOverlapBox(const DirectX::SimpleMath::Vector3& min, const DirectX::SimpleMath::Vector3& max, Fn&& fn) const
+        {
+            const float query_min[3] = {min.x, min.y, min.z};
+            const float query_max[3] = {max.x, max.y, max.z};
+            ForEachLeafItem([&](const float node_min[3], const float node_max[3])
+            {
+                return Overlaps(node_min, node_max, query_min, query_max);
+            }, [&](const Item& item)
+            {
+                float item_min[3], item_max[3];
+                ToFloats(item.box, item_min, item_max);
+                if (Overlaps(item_min, item_max, query_min, query_max))
+                    fn(item.id);
+            });
+        }
+
+        // fn(id) for every box intersecting sphere.
+        template <typename Fn>
+        void ForEachOverlapSphere(const DirectX::SimpleMath::Vector3& center, float radius, Fn&& fn) const
+        {
+            const float point[3] = {center.x, center.y, center.z};
+            const float radius_sq = radius * radius;
+            ForEachLeafItem([&](const float node_min[3], const float node_max[3])
+            {
+                return DistanceSq(node_min, node_max, point) <= radius_sq;
+            }, [&](const Item& item)
+            {
+                float item_min[3], item_max[3];
+                ToFloats(item.box, item_min, item_max);
+                if (DistanceSq(item_min, item_max, point) <= radius_sq)
+                    fn(item.id);
+            });
+        }
+
+        // Nearer child first. fn(id, t) for every box ray enters within [0, max_t] and returns new max_t,
+        // so closest-hit queries shrink the search. inv_direction has to be finite.
+        template <typename Fn>
+        void ForEachRayHit(const DirectX::SimpleMath::Vector3& origin, const DirectX::SimpleMath::Vector3& inv_direction, float max_t, Fn&& fn) const
+        {
+            const float o[3] = {origin.x, origin.y, origin.z};
+            const float inv[3] = {inv_direction.x, inv_direction.y, inv_direction.z};
+            ForEachNearFirst([&](const float box_min[3], const float box_max[3], float& key)
+            {
+                return RayEnter(box_min, box_max, o, inv, max_t, key);
+            }, [&](OrthoTree::index_t id, float t)
+            {
+                max_t = fn(id, t);
+            });
+        }
+
+        // Nearest boxes first. fn(id, squared distance) for every box not further than max_distance_sq,
+        // returns new bound, boxes further than it are skipped.
+        template <typename Fn>
+        void ForEachNearest(const DirectX::SimpleMath::Vector3& point, float max_distance_sq, Fn&& fn) const
+        {
+            const float p[3] = {point.x, point.y, point.z};
+            ForEachNearFirst([&](const float box_min[3], const float box_max[3], float& key)
+            {
+                key = DistanceSq(box_min, box_max, p);
+                return key <= max_distance_sq;
+            }, [&](OrthoTree::index_t id, float distance_sq)
+            {
+                max_distance_sq = fn(id, distance_sq);
+            });
+        }
+
+    private:
+        struct Node
+        {
+            float min[3];
+            uint32_t first_item;
+            float max[3];
+            uint32_t item_count;
+            // 0 for leaves, root is never a right child
+            uint32_t right_child;
+
+            bool IsLeaf() const
+            {
+                return right_child == 0;
+            }
+        };
+
+        std::vector<Node> nodes_;
+        std::vector<Item> items_;
+
+        static size_t CountTrailingZeros(uint64_t bits)
+        {
+#if defined(_MSC_VER)
+            unsigned long index;
+            _BitScanForward64(&index, bits);
+            return index;
+#else
+            return static_cast<size_t>(__builtin_ctzll(bits));
+#endif
+        }
+
+        static void ToFloats(const OrthoTree::BoundingBox3D& box, float min[3], float max[3])
+        {
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                min[axis] = static_cast<float>(box.Min[axis]);
+                max[axis] = static_cast<float>(box.Max[axis]);
+            }
+        }
+
+        static bool Overlaps(const float min[3], const float max[3], const float query_min[3], const float query_max[3])
+        {
+            return min[0] <= query_max[0] && max[0] >= query_min[0]
+                && min[1] <= query_max[1] && max[1] >= query_min[1]
+                && min[2] <= query_max[2] && max[2] >= query_min[2];
+        }
+
+        static float DistanceSq(const float min[3], const float max[3], const float point[3])
+        {
+            float result = 0.0f;
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                const float d = std::max({min[axis] - point[axis], point[axis] - max[axis], 0.0f});
+                result += d * d;
+            }
+            return result;
+        }
+
+        // slab test, finite inv keeps 0 * inv from turning into NaN for rays starting on a slab plane
+        static bool RayEnter(const float min[3], const float max[3], const float origin[3], const float inv[3], float max_t, float& t_enter)
+        {
+            float enter = 0.0f;
+            float exit = max_t;
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                const float t1 = (min[axis] - origin[axis]) * inv[axis];
+                const float t2 = (max[axis] - origin[axis]) * inv[axis];
+                enter = std::max(enter, std::min(t1, t2));
+                exit = std::min(exit, std::max(t1, t2));
+            }
+            t_enter = enter;
+            return enter <= exit;
+        }
+
+        // depth-first over nodes accepted by node_test(min, max), item_fn(item) for every item of accepted leaves
+        template <typename NodeTest, typename ItemFn>
+        void ForEachLeafItem(NodeTest&& node_test, ItemFn&& item_fn) const
+        {
+            if (nodes_.empty())
+                return;
+
+            std::array<uint32_t, MaxDepth + 2> stack;
+            uint32_t stack_size = 0;
+            stack[stack_size++] = 0;
+
+            while (stack_size)
+            {
+                const uint32_t node_index = stack[--stack_size];
+                const auto& node = nodes_[node_index];
+                if (!node_test(node.min, node.max))
+                    continue;
+
+                if (node.IsLeaf())
+                {
+                    for (uint32_t i = node.first_item; i < node.first_item + node.item_count; ++i)
+                        item_fn(items_[i]);
+                    continue;
+                }
+
+                stack[stack_size++] = node.right_child;
+                stack[stack_size++] = node_index + 1;
+            }
+        }
+
+        // Branch and bound: box_test(min, max, key) accepts a box and gives its key under current bound,
+        // nearer child is visited first, nodes are re-tested when popped since hit_fn may have shrunk the bound.
+        template <typename BoxTest, typename HitFn>
+        void ForEachNearFirst(BoxTest&& box_test, HitFn&& hit_fn) const
+        {
+            if (nodes_.empty())
+                return;
+
+            std::array<uint32_t, MaxDepth + 2> stack;
+            uint32_t stack_size = 0;
+            stack[stack_size++] = 0;
+
+            while (stack_size)
+            {
+                const uint32_t node_index = stack[--stack_size];
+                const auto& node = nodes_[node_index];
+                float key;
+                if (!box_test(node.min, node.max, key))
+                    continue;
+
+                if (node.IsLeaf())
+                {
+                    for (uint32_t i = node.first_item; i < node.first_item + node.item_count; ++i)
+                    {
+                        float item_min[3], item_max[3];
+                        ToFloats(items_[i].box, item_min, item_max);
+                        float item_key;
+                        if (box_test(item_min, item_max, item_key))
+                            hit_fn(items_[i].id, item_key);
+                    }
+                    continue;
+                }
+
+                const uint32_t left = node_index + 1;
+                const uint32_t right = node.right_child;
+                float left_key, right_key;
+                const bool left_hit = box_test(nodes_[left].min, nodes_[left].max, left_key);
+                const bool right_hit = box_test(nodes_[right].min, nodes_[right].max, right_key);
+
+                // nearer child is pushed last so it is popped first
+                if (left_hit && right_hit)
+                {
+                    stack[stack_size++] = left_key <= right_key ? right : left;
+                    stack[stack_size++] = left_key <= right_key ? left : right;
+                }
+                else if (left_hit)
+                    stack[stack_size++] = left;
+                else if (right_hit)
+                    stack[stack_size++] = right;
+            }
+        }
+
+        static float Centroid(const Item& item, int axis)
+        {
+            return static_cast<float>((item.box.Min[axis] + item.box.Max[axis]) * 0.5);
+        }
+
+        static float HalfArea(const float min[3], const float max[3])
+        {
+            const float dx = max[0] - min[0], dy = max[1] - min[1], dz = max[2] - min[2];
+            return dx * dy + dy * dz + dz * dx;
+        }
+
+        struct Bounds
+        {
+            float min[3] = {std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max()};
+            float max[3] = {-std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max()};
+
+            void Grow(const OrthoTree::BoundingBox3D& box)
+            {
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    min[axis] = std::min(min[axis], static_cast<float>(box.Min[axis]));
+                    max[axis] = std::max(max[axis], static_cast<float>(box.Max[axis]));
+                }
+            }
+
+            void Grow(const Bounds& other)
+            {
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    min[axis] = std::min(min[axis], other.min[axis]);
+                    max[axis] = std::max(max[axis], other.max[axis]);
+                }
+            }
+
+            float HalfArea() const
+            {
+                return min[0] > max[0] ? 0.0f : StaticBVH::HalfArea(min, max);
+            }
+        };
+
+        void SetBounds(Node& node, uint32_t first, uint32_t count) const
+        {
+            Bounds bounds;
+            for (uint32_t i = first; i < first + count; ++i)
+                bounds.Grow(items_[i].box);
+            std::copy_n(bounds.min, 3, node.min);
+            std::copy_n(bounds.max, 3, node.max);
+        }
+
+        static void SetBounds(Node& node, const Node& left, const Node& right)
+        {
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                node.min[axis] = std::min(left.min[axis], right.min[axis]);
+                node.max[axis] = std::max(left.max[axis], right.max[axis]);
+            }
+        }
+
+        uint32_t BuildNode(uint32_t first, uint32_t count, uint32_t depth)
+        {
+            const auto node_index = static_cast<uint32_t>(nodes_.size());
+            nodes_.push_back(Node{{}, first, {}, count, 0});
+            SetBounds(nodes_[node_index], first, count);
+
+            if (count <= MaxLeafSize || depth >= MaxDepth)
+                return node_index;
+
+            Bounds centroid_bounds;
+            for (uint32_t i = first; i < first + count; ++i)
+            {
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    centroid_bounds.min[axis] = std::min(centroid_bounds.min[axis], Centroid(items_[i], axis));
+                    centroid_bounds.max[axis] = std::max(centroid_bounds.max[axis], Centroid(items_[i], axis));
+                }
+            }
+
+            // binned SAH: cost of split is area(left) * count(left) + area(right) * count(right)
+            int best_axis = -1;
+            uint32_t best_split = 0;
+            float best_cost = HalfArea(nodes_[node_index].min, nodes_[node_index].max) * static_cast<float>(count);
+
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                const float extent = centroid_bounds.max[axis] - centroid_bounds.min[axis];
+                if (extent <= 0.0f)
+                    continue;
+
+                std::array<Bounds, BinCount> bins;
+                std::array<uint32_t, BinCount> bin_counts{};
+                const float scale = static_cast<float>(BinCount) / extent;
+                for (uint32_t i = first; i < first + count; ++i)
+                {
+                    const auto bin = std::min(BinCount - 1, static_cast<uint32_t>((Centroid(items_[i], axis) - centroid_bounds.min[axis]) * scale));
+                    bins[bin].Grow(items_[i].box);
+                    ++bin_counts[bin];
+                }
+
+                // right-to-left sweep gives cost of every right side
+                std::array<float, BinCount> right_costs{};
+                Bounds right;
+                uint32_t right_count = 0;
+                for (uint32_t bin = BinCount - 1; bin > 0; --bin)
+                {
+                    right.Grow(bins[bin]);
+                    right_count += bin_counts[bin];
+                    right_costs[bin] = right.HalfArea() * static_cast<float>(right_count);
+                }
+
+                Bounds left;
+                uint32_t left_count = 0;
+                for (uint32_t bin = 0; bin < BinCount - 1; ++bin)
+                {
+                    left.Grow(bins[bin]);
+                    left_count += bin_counts[bin];
+                    if (left_count == 0 || left_count == count)
+                        continue;
+
+                    const float cost = left.HalfArea() * static_cast<float>(left_count) + right_costs[bin + 1];
+                    if (cost < best_cost)
+                    {
+                        best_cost = cost;
+                        best_axis = axis;
+                        best_split = bin + 1;
+                    }
+                }
+            }
+
+            // no split is better than a leaf
+            if (best_axis < 0)
+                return node_index;
+
+            const float extent = centroid_bounds.max[best_axis] - centroid_bounds.min[best_axis];
+            const float scale = static_cast<float>(BinCount) / extent;
+            auto middle = std::partition(items_.begin() + first, items_.begin() + first + count, [&](const Item& item)
+            {
+                return std::min(BinCount - 1, static_cast<uint32_t>((Centroid(item, best_axis) - centroid_bounds.min[best_axis]) * scale)) < best_split;
+            });
+            const auto left_count = static_cast<uint32_t>(middle - (items_.begin() + first));
+
+            BuildNode(first, left_count, depth + 1);
+            const uint32_t right_child = BuildNode(first + left_count, count - left_count, depth + 1);
+            nodes_[node_index].right_child = right_child;
+            return node_index;
+        }
+
+        // Box is outside when it is behind any plane, inside when it is in front of all of them.
+        static bool IntersectsFrustum(const float min[3], const float max[3], const std::vector<DirectX::SimpleMath::Plane>& planes, float tolerance, bool& is_inside)
+        {
+            is_inside = true;
+            for (const auto& plane : planes)
+            {
+                const float far_dist = plane.x * (plane.x >= 0 ? max[0] : min[0])
+                    + plane.y * (plane.y >= 0 ? max[1] : min[1])
+                    + plane.z * (plane.z >= 0 ? max[2] : min[2]) - plane.w;
+                if (far_dist < -tolerance)
+                    return false;
+
+                const float near_dist = plane.x * (plane.x >= 0 ? min[0] : max[0])
+                    + plane.y * (plane.y >= 0 ? min[1] : max[1])
+                    + plane.z * (plane.z >= 0 ? min[2] : max[2]) - plane.w;
+                if (near_dist < -tolerance)
+                    is_inside = false;
+            }
+            return true;
+        }
+
+        static bool IntersectsFrustum(const OrthoTree::BoundingBox3D& box, const std::vector<DirectX::SimpleMath::Plane>& planes, float tolerance)
+        {
+            const float min[3] = {static_cast<float>(box.Min[0]), static_cast<float>(box.Min[1]), static_cast<float>(box.Min[2])};
+            const float max[3] = {static_cast<float>(box.Max[0]), static_cast<float>(box.Max[1]), static_cast<float>(box.Max[2])};
+            bool is_inside;
+            return IntersectsFrustum(min, max, planes, tolerance, is_inside);
+        }
+    };
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include<algorithm>
+#include<typeindex>
+#include<vector>
+
+namespace GiiGa
+{
+    struct TickSchedulerSettings
+    {
+        // worker ticks of one group run on WorkerPool, otherwise every tick list runs serially on main thread
+        static inline bool ParallelTicks = true;
+    };
+
+    /*
+     * What Tick of one component type touches, used to schedule tick lists of a group.
+     * Own type always counts as written. Types with caching getters (TransformComponent) have to be declared written.
+     * Ticks running on workers must not create or destroy components and game objects.
+     */
+    struct TickAccess
+    {
+        // undeclared access conflicts with every other type and runs alone on main thread
+        bool declared = false;
+        bool main_thread = true;
+        std::vector<std::type_index> reads;
+        std::vector<std::type_index> writes;
+
+        static TickAccess Undeclared()
+        {
+            return {};
+        }
+
+        static TickAccess MainThread()
+        {
+            TickAccess access;
+            access.declared = true;
+            return access;
+        }
+
+        static TickAccess Workers()
+        {
+            TickAccess access;
+            access.declared = true;
+            access.main_thread = false;
+            return access;
+        }
+
+        template <typename... Ts>
+        TickAccess& Reads()
+        {
+            (reads.emplace_back(typeid(Ts)), ...);
+            return *this;
+        }
+
+        template <typename... Ts>
+        TickAccess& Writes()
+        {
+            (writes.emplace_back(typeid(Ts)), ...);
+            return *this;
+        }
+
+        static bool Conflict(const TickAccess& lhs, std::type_index lhs_type, const TickAccess& rhs, std::type_index rhs_type)
+        {
+            if (!lhs.declared || !rhs.declared) return true;
+            return WritesInto(lhs, lhs_type, rhs, rhs_type) || WritesInto(rhs, rhs_type, lhs, lhs_type);
+        }
+
+    private:
+        static bool Contains(const std::vector<std::type_index>& types, std::type_index type)
+        {
+            return std::find(types.begin(), types.end(), type) != types.end();
+        }
+
+        // writer changes something reader reads or writes
+        static bool WritesInto(const TickAccess& writer, std::type_index writer_type, const TickAccess& reader, std::type_index reader_type)
+        {
+            auto touched = [&](std::type_index type)
+            {
+                return type == reader_type || Contains(reader.reads, type) || Contains(reader.writes, type);
+            };
+
+            if (touched(writer_type)) return true;
+            return std::any_of(writer.writes.begin(), writer.writes.end(), touched);
+        }
+    };
+}
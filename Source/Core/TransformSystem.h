@@ -0,0 +1,634 @@
+#pragma once
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include<directxtk12/SimpleMath.h>
+#include<DirectXMath.h>
+#include<algorithm>
+#include<cstdint>
+#include<memory>
+#include<span>
+#include<vector>
+
+#include<DXMathUtils.h>
+#include<EventSystem.h>
+#include<WorkerPool.h>
+
+namespace GiiGa
+{
+    class TransformComponent;
+
+    struct TransformSystemSettings
+    {
+        // propagate hierarchy levels on WorkerPool, results do not depend on thread count
+        static inline bool ParallelPropagation = true;
+        // levels smaller than two tasks are propagated on the calling thread
+        static inline uint32_t MinEntriesPerTask = 2048;
+    };
+
+    enum TransformAttach : uint8_t
+    {
+        AttachTranslation = 1 << 0,
+        AttachRotate = 1 << 1,
+        AttachScale = 1 << 2,
+        AttachAll = AttachTranslation | AttachRotate | AttachScale,
+    };
+
+    /*
+     * Owns local TRS, local and world matrices of every TransformComponent in SoA arrays.
+     * Dense arrays are kept sorted so a parent always precedes its children,
+     * Update recomputes dirty entries and their descendants in one linear pass,
+     * or level by level on WorkerPool when the hierarchy is large enough.
+     * Components keep a stable sparse id, dense index changes on sort and removal.
+     * Reading a matrix of a dirty entry before Update resolves its parent chain on demand.
+     * World TRS is decomposed on first read and cached until the world matrix version changes.
+     * Changes are reported once per Update: OnTransformsChanged gets the ids of all moved transforms,
+     * then OnUpdateTransform of every moved component is invoked.
+     * Reports are deferred, so a listener mirroring transforms into another system also gets the changes
+     * it wrote itself, possibly after that system moved on; it has to recognize and skip them.
+     */
+    class TransformSystem
+    {
+    public:
+        static constexpr uint32_t InvalidId = UINT32_MAX;
+
+        static TransformSystem& GetInstance()
+        {
+            if (!instance_) instance_ = std::make_unique<TransformSystem>();
+            return *instance_;
+        }
+
+        uint32_t Create(TransformComponent* owner, const Vector3& location, const Quaternion& rotation, const Vector3& scale)
+        {
+            uint32_t id;
+            if (!free_ids_.empty())
+            {
+                id = free_ids_.back();
+                free_ids_.pop_back();
+            }
+            else
+            {
+                id = static_cast<uint32_t>(dense_of_.size());
+                dense_of_.push_back(InvalidId);
+            }
+
+            dense_of_[id] = static_cast<uint32_t>(ids_.size());
+            ids_.push_back(id);
+            owners_.push_back(owner);
+            locations_.push_back(location);
+            rotations_.push_back(rotation);
+            scales_.push_back(scale);
+            local_.push_back(Matrix::Identity);
+            world_.push_back(Matrix::Identity);
+            parent_ids_.push_back(InvalidId);
+            parents_.push_back(-1);
+            child_counts_.push_back(0);
+            attach_.push_back(AttachAll);
+            local_dirty_.push_back(1);
+            world_changed_.push_back(0);
+            lazy_stamp_.push_back(0);
+            world_versions_.push_back(1);
+            trs_versions_.push_back(0);
+            world_locations_.push_back(location);
+            world_rotations_.push_back(rotation);
+            world_scales_.push_back(scale);
+
+            MarkDirty();
+            return id;
+        }
+
+        // children of a removed entry become roots
+        void Destroy(uint32_t id)
+        {
+            if (DenseOf(id) == InvalidId) return;
+
+            SetParent(id, InvalidId);
+            const uint32_t dense = dense_of_[id];
+            if (child_counts_[dense] > 0)
+            {
+                for (uint32_t i = 0; i < ids_.size(); ++i)
+                {
+                    if (parent_ids_[i] != id) continue;
+                    parent_ids_[i] = InvalidId;
+                    parents_[i] = -1;
+                    local_dirty_[i] = 1;
+                }
+            }
+
+            const uint32_t last = static_cast<uint32_t>(ids_.size() - 1);
+            if (dense != last)
+            {
+                // in a sorted order the last entry has no children, only its own parent link can break
+                if (child_counts_[last] > 0 || parents_[last] >= static_cast<int32_t>(dense))
+                    order_dirty_ = true;
+                // its depth level may now start after the moved entry
+                if (parents_[last] >= 0)
+                    levels_dirty_ = true;
+                MoveEntry(last, dense);
+            }
+            PopBack();
+
+            dense_of_[id] = InvalidId;
+            free_ids_.push_back(id);
+            MarkDirty();
+        }
+
+        bool IsAlive(uint32_t id) const
+        {
+            return DenseOf(id) != InvalidId;
+        }
+
+        TransformComponent* GetOwner(uint32_t id) const
+        {
+            const uint32_t dense = DenseOf(id);
+            return dense == InvalidId ? nullptr : owners_[dense];
+        }
+
+        void SetOwner(uint32_t id, TransformComponent* owner)
+        {
+            owners_[dense_of_[id]] = owner;
+        }
+
+        const Vector3& GetLocation(uint32_t id) const { return locations_[dense_of_[id]]; }
+        const Quaternion& GetRotation(uint32_t id) const { return rotations_[dense_of_[id]]; }
+        const Vector3& GetScale(uint32_t id) const { return scales_[dense_of_[id]]; }
+
+        void SetLocal(uint32_t id, const Vector3& location, const Quaternion& rotation, const Vector3& scale)
+        {
+            const uint32_t dense = dense_of_[id];
+            locations_[dense] = location;
+            rotations_[dense] = rotation;
+            scales_[dense] = scale;
+            MarkLocalDirty(dense);
+        }
+
+        void SetLocation(uint32_t id, const Vector3& location)
+        {
+            const uint32_t dense = dense_of_[id];
+            locations_[dense] = location;
+            MarkLocalDirty(dense);
+        }
+
+        void SetRotation(uint32_t id, const Quaternion& rotation)
+        {
+            const uint32_t dense = dense_of_[id];
+            rotations_[dense] = rotation;
+            MarkLocalDirty(dense);
+        }
+
+        void SetScale(uint32_t id, const Vector3& scale)
+        {
+            const uint32_t dense = dense_of_[id];
+            scales_[dense] = scale;
+            MarkLocalDirty(dense);
+        }
+
+        uint32_t GetParent(uint32_t id) const { return parent_ids_[dense_of_[id]]; }
+
+        // returns false when parent is unknown or attaching would create a cycle
+        bool SetParent(uint32_t id, uint32_t parent_id)
+        {
+            const uint32_t dense = dense_of_[id];
+            if (parent_ids_[dense] == parent_id) return true;
+            if (parent_id != InvalidId)
+            {
+                if (DenseOf(parent_id) == InvalidId) return false;
+                for (uint32_t it = parent_id; it != InvalidId; it = parent_ids_[dense_of_[it]])
+                {
+                    if (it == id) return false;
+                }
+            }
+
+            if (parent_ids_[dense] != InvalidId) --child_counts_[dense_of_[parent_ids_[dense]]];
+            parent_ids_[dense] = parent_id;
+            if (parent_id != InvalidId) ++child_counts_[dense_of_[parent_id]];
+
+            if (parent_id == InvalidId)
+            {
+                parents_[dense] = -1;
+            }
+            else if (dense_of_[parent_id] < dense)
+            {
+                parents_[dense] = static_cast<int32_t>(dense_of_[parent_id]);
+            }
+            else
+            {
+                order_dirty_ = true;
+            }
+            // the entry may now share a depth level with its parent
+            if (parent_id != InvalidId) levels_dirty_ = true;
+
+            MarkLocalDirty(dense);
+            return true;
+        }
+
+        uint8_t GetAttachFlags(uint32_t id) const { return attach_[dense_of_[id]]; }
+
+        void SetAttachFlags(uint32_t id, uint8_t flags)
+        {
+            const uint32_t dense = dense_of_[id];
+            if (attach_[dense] == flags) return;
+            attach_[dense] = flags;
+            MarkLocalDirty(dense);
+        }
+
+        const Matrix& GetLocalMatrix(uint32_t id)
+        {
+            const uint32_t dense = dense_of_[id];
+            if (local_dirty_[dense]) ComposeLocal(dense);
+            return local_[dense];
+        }
+
+        const Matrix& GetWorldMatrix(uint32_t id)
+        {
+            return ResolveWorld(dense_of_[id]);
+        }
+
+        // incremented every time the world matrix is recomputed
+        uint64_t GetWorldVersion(uint32_t id)
+        {
+            const uint32_t dense = dense_of_[id];
+            ResolveWorld(dense);
+            return world_versions_[dense];
+        }
+
+        const Vector3& GetWorldLocation(uint32_t id) { return world_locations_[ResolveWorldTRS(dense_of_[id])]; }
+        const Quaternion& GetWorldRotation(uint32_t id) { return world_rotations_[ResolveWorldTRS(dense_of_[id])]; }
+        const Vector3& GetWorldScale(uint32_t id) { return world_scales_[ResolveWorldTRS(dense_of_[id])]; }
+
+        // fills world positions and rotations of ids, output spans must be at least ids.size() long
+        void GetWorldPoses(std::span<const uint32_t> ids, std::span<Vector3> locations, std::span<Quaternion> rotations)
+        {
+            for (size_t i = 0; i < ids.size(); ++i)
+            {
+                const uint32_t dense = ResolveWorldTRS(dense_of_[ids[i]]);
+                locations[i] = world_locations_[dense];
+                rotations[i] = world_rotations_[dense];
+            }
+        }
+
+        size_t Size() const { return ids_.size(); }
+
+        // batched notification for systems, ids may belong to transforms destroyed by earlier listeners
+        EventDispatcher<std::span<const uint32_t>> OnTransformsChanged;
+
+        // sync point: propagates pending changes and notifies listeners of every transform whose world matrix changed
+        static void Update()
+        {
+            auto& instance = GetInstance();
+            instance.Propagate();
+            instance.NotifyChanged();
+        }
+
+    private:
+        static inline std::unique_ptr<TransformSystem> instance_ = nullptr;
+
+        // sparse id -> dense index
+        std::vector<uint32_t> dense_of_;
+        std::vector<uint32_t> free_ids_;
+
+        // dense arrays, parents before children while order_dirty_ is false
+        std::vector<uint32_t> ids_;
+        std::vector<TransformComponent*> owners_;
+        std::vector<Vector3> locations_;
+        std::vector<Quaternion> rotations_;
+        std::vector<Vector3> scales_;
+        std::vector<Matrix> local_;
+        std::vector<Matrix> world_;
+        std::vector<uint32_t> parent_ids_;
+        std::vector<int32_t> parents_;
+        std::vector<uint32_t> child_counts_;
+        std::vector<uint8_t> attach_;
+        std::vector<uint8_t> local_dirty_;
+        std::vector<uint8_t> world_changed_;
+        // mutation_ value at which world_ was resolved on demand
+        std::vector<uint64_t> lazy_stamp_;
+        // decomposed world TRS, valid while trs_versions_ equals world_versions_
+        std::vector<uint64_t> world_versions_;
+        std::vector<uint64_t> trs_versions_;
+        std::vector<Vector3> world_locations_;
+        std::vector<Quaternion> world_rotations_;
+        std::vector<Vector3> world_scales_;
+
+        bool order_dirty_ = false;
+        // level_offsets_ no longer separate parents from children, order may still be valid
+        bool levels_dirty_ = true;
+        // start of every depth level in dense arrays, entries appended after the sort belong to the last one
+        std::vector<uint32_t> level_offsets_;
+        bool any_dirty_ = false;
+        uint64_t mutation_ = 1;
+
+        std::vector<uint32_t> changed_ids_;
+        std::vector<uint32_t> depth_scratch_;
+        std::vector<uint32_t> order_scratch_;
+        std::vector<uint32_t> offset_scratch_;
+        std::vector<uint8_t> visited_scratch_;
+
+        uint32_t DenseOf(uint32_t id) const
+        {
+            return id < dense_of_.size() ? dense_of_[id] : InvalidId;
+        }
+
+        void MarkDirty()
+        {
+            any_dirty_ = true;
+            ++mutation_;
+        }
+
+        void MarkLocalDirty(uint32_t dense)
+        {
+            local_dirty_[dense] = 1;
+            MarkDirty();
+        }
+
+        void ComposeLocal(uint32_t dense)
+        {
+            using namespace DirectX;
+            XMMATRIX m = XMMatrixMultiply(XMMatrixScalingFromVector(XMLoadFloat3(&scales_[dense])),
+                                          XMMatrixRotationQuaternion(XMLoadFloat4(&rotations_[dense])));
+            m.r[3] = XMVectorSetW(XMLoadFloat3(&locations_[dense]), 1.0f);
+            XMStoreFloat4x4(&local_[dense], m);
+        }
+
+        void ComposeWorld(uint32_t dense, const Matrix& parent_world)
+        {
+            using namespace DirectX;
+            const XMMATRIX local = XMLoadFloat4x4(&local_[dense]);
+            XMMATRIX parent = XMLoadFloat4x4(&parent_world);
+
+            const uint8_t attach = attach_[dense];
+            if (attach != AttachAll)
+            {
+                // rebuild parent world from the inherited components only
+                XMVECTOR scale, rotation, translation;
+                XMMatrixDecompose(&scale, &rotation, &translation, parent);
+                parent = XMMatrixMultiply(XMMatrixScalingFromVector((attach & AttachScale) ? scale : g_XMOne),
+                                          XMMatrixRotationQuaternion((attach & AttachRotate) ? rotation : XMQuaternionIdentity()));
+                parent.r[3] = (attach & AttachTranslation) ? XMVectorSetW(translation, 1.0f) : g_XMIdentityR3;
+            }
+
+            XMStoreFloat4x4(&world_[dense], XMMatrixMultiply(local, parent));
+            ++world_versions_[dense];
+        }
+
+        const Matrix& ResolveWorld(uint32_t dense)
+        {
+            if (!any_dirty_ || lazy_stamp_[dense] == mutation_) return world_[dense];
+
+            bool stale = false;
+            for (uint32_t it = dense; it != InvalidId;)
+            {
+                if (local_dirty_[it])
+                {
+                    stale = true;
+                    break;
+                }
+                const uint32_t parent_id = parent_ids_[it];
+                it = parent_id == InvalidId ? InvalidId : dense_of_[parent_id];
+            }
+
+            if (stale)
+            {
+                // dirty flags stay set, the per-frame pass still has to see this subtree as changed
+                ComposeLocal(dense);
+                const uint32_t parent_id = parent_ids_[dense];
+                if (parent_id == InvalidId)
+                    SetRootWorld(dense);
+                else
+                    ComposeWorld(dense, ResolveWorld(dense_of_[parent_id]));
+            }
+
+            lazy_stamp_[dense] = mutation_;
+            return world_[dense];
+        }
+
+        uint32_t ResolveWorldTRS(uint32_t dense)
+        {
+            using namespace DirectX;
+            ResolveWorld(dense);
+            if (trs_versions_[dense] == world_versions_[dense]) return dense;
+
+            XMVECTOR scale, rotation, translation;
+            XMMatrixDecompose(&scale, &rotation, &translation, XMLoadFloat4x4(&world_[dense]));
+            XMStoreFloat3(&world_scales_[dense], scale);
+            XMStoreFloat4(&world_rotations_[dense], rotation);
+            XMStoreFloat3(&world_locations_[dense], translation);
+            trs_versions_[dense] = world_versions_[dense];
+            return dense;
+        }
+
+        void SetRootWorld(uint32_t dense)
+        {
+            world_[dense] = local_[dense];
+            ++world_versions_[dense];
+        }
+
+        void Propagate()
+        {
+            changed_ids_.clear();
+            if (!any_dirty_) return;
+
+            const size_t count = ids_.size();
+            const bool parallel = TransformSystemSettings::ParallelPropagation
+                && count >= size_t{TransformSystemSettings::MinEntriesPerTask} * 2
+                && WorkerPool::GetInstance().WorkerCount() > 0;
+
+            if (order_dirty_ || (parallel && levels_dirty_)) SortByDepth();
+
+            if (parallel)
+            {
+                // entries of one level only read worlds of previous levels
+                for (size_t level = 0; level + 1 < level_offsets_.size(); ++level)
+                {
+                    const size_t begin = std::min<size_t>(level_offsets_[level], count);
+                    const size_t end = level + 2 == level_offsets_.size() ? count : std::min<size_t>(level_offsets_[level + 1], count);
+                    WorkerPool::GetInstance().ParallelFor(end - begin, TransformSystemSettings::MinEntriesPerTask, [this, begin](size_t b, size_t e)
+                    {
+                        PropagateRange(begin + b, begin + e);
+                    });
+                }
+            }
+            else
+            {
+                PropagateRange(0, count);
+            }
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                if (world_changed_[i]) changed_ids_.push_back(ids_[i]);
+            }
+
+            any_dirty_ = false;
+            ++mutation_;
+        }
+
+        void PropagateRange(size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                const int32_t parent = parents_[i];
+                const bool changed = local_dirty_[i] || (parent >= 0 && world_changed_[parent]);
+                world_changed_[i] = changed;
+                if (!changed) continue;
+
+                // resolved on demand after the last mutation, matrices and cached TRS are current
+                if (lazy_stamp_[i] == mutation_)
+                {
+                    local_dirty_[i] = 0;
+                    continue;
+                }
+
+                if (local_dirty_[i])
+                {
+                    ComposeLocal(static_cast<uint32_t>(i));
+                    local_dirty_[i] = 0;
+                }
+
+                if (parent < 0)
+                    SetRootWorld(static_cast<uint32_t>(i));
+                else
+                    ComposeWorld(static_cast<uint32_t>(i), world_[parent]);
+            }
+        }
+
+        // stable counting sort by hierarchy depth, rebuilds dense parent indices
+        void SortByDepth()
+        {
+            const uint32_t count = static_cast<uint32_t>(ids_.size());
+            constexpr uint32_t Unknown = UINT32_MAX;
+
+            depth_scratch_.assign(count, Unknown);
+            uint32_t max_depth = 0;
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                uint32_t depth = 0;
+                uint32_t it = i;
+                while (depth_scratch_[it] == Unknown && parent_ids_[it] != InvalidId)
+                {
+                    it = dense_of_[parent_ids_[it]];
+                    ++depth;
+                }
+                depth += depth_scratch_[it] == Unknown ? 0 : depth_scratch_[it];
+
+                // write depths back along the walked chain
+                for (uint32_t back = i, d = depth; depth_scratch_[back] == Unknown; --d)
+                {
+                    depth_scratch_[back] = d;
+                    if (parent_ids_[back] == InvalidId) break;
+                    back = dense_of_[parent_ids_[back]];
+                }
+                max_depth = std::max(max_depth, depth);
+            }
+
+            level_offsets_.assign(max_depth + 2, 0);
+            for (uint32_t i = 0; i < count; ++i)
+                ++level_offsets_[depth_scratch_[i] + 1];
+            for (uint32_t d = 1; d < level_offsets_.size(); ++d)
+                level_offsets_[d] += level_offsets_[d - 1];
+
+            // order_scratch_[new dense] = old dense
+            offset_scratch_.assign(level_offsets_.begin(), level_offsets_.end());
+            order_scratch_.resize(count);
+            for (uint32_t i = 0; i < count; ++i)
+                order_scratch_[offset_scratch_[depth_scratch_[i]]++] = i;
+
+            Permute(ids_);
+            Permute(owners_);
+            Permute(locations_);
+            Permute(rotations_);
+            Permute(scales_);
+            Permute(local_);
+            Permute(world_);
+            Permute(parent_ids_);
+            Permute(child_counts_);
+            Permute(attach_);
+            Permute(local_dirty_);
+            Permute(lazy_stamp_);
+            Permute(world_versions_);
+            Permute(trs_versions_);
+            Permute(world_locations_);
+            Permute(world_rotations_);
+            Permute(world_scales_);
+
+            for (uint32_t i = 0; i < count; ++i)
+                dense_of_[ids_[i]] = i;
+            for (uint32_t i = 0; i < count; ++i)
+                parents_[i] = parent_ids_[i] == InvalidId ? -1 : static_cast<int32_t>(dense_of_[parent_ids_[i]]);
+
+            order_dirty_ = false;
+            levels_dirty_ = false;
+        }
+
+        // in place along cycles of order_scratch_, no allocation
+        template <typename T>
+        void Permute(std::vector<T>& values)
+        {
+            const uint32_t count = static_cast<uint32_t>(order_scratch_.size());
+            visited_scratch_.assign(count, 0);
+            for (uint32_t start = 0; start < count; ++start)
+            {
+                if (visited_scratch_[start] || order_scratch_[start] == start) continue;
+
+                T first = std::move(values[start]);
+                uint32_t to = start;
+                for (uint32_t from = order_scratch_[to]; from != start; to = from, from = order_scratch_[to])
+                {
+                    values[to] = std::move(values[from]);
+                    visited_scratch_[to] = 1;
+                }
+                values[to] = std::move(first);
+                visited_scratch_[to] = 1;
+            }
+        }
+
+        void MoveEntry(uint32_t from, uint32_t to)
+        {
+            ids_[to] = ids_[from];
+            owners_[to] = owners_[from];
+            locations_[to] = locations_[from];
+            rotations_[to] = rotations_[from];
+            scales_[to] = scales_[from];
+            local_[to] = local_[from];
+            world_[to] = world_[from];
+            parent_ids_[to] = parent_ids_[from];
+            parents_[to] = parents_[from];
+            child_counts_[to] = child_counts_[from];
+            attach_[to] = attach_[from];
+            local_dirty_[to] = local_dirty_[from];
+            world_changed_[to] = world_changed_[from];
+            lazy_stamp_[to] = lazy_stamp_[from];
+            world_versions_[to] = world_versions_[from];
+            trs_versions_[to] = trs_versions_[from];
+            world_locations_[to] = world_locations_[from];
+            world_rotations_[to] = world_rotations_[from];
+            world_scales_[to] = world_scales_[from];
+            dense_of_[ids_[to]] = to;
+        }
+
+        void PopBack()
+        {
+            ids_.pop_back();
+            owners_.pop_back();
+            locations_.pop_back();
+            rotations_.pop_back();
+            scales_.pop_back();
+            local_.pop_back();
+            world_.pop_back();
+            parent_ids_.pop_back();
+            parents_.pop_back();
+            child_counts_.pop_back();
+            attach_.pop_back();
+            local_dirty_.pop_back();
+            world_changed_.pop_back();
+            lazy_stamp_.pop_back();
+            world_versions_.pop_back();
+            trs_versions_.pop_back();
+            world_locations_.pop_back();
+            world_rotations_.pop_back();
+            world_scales_.pop_back();
+        }
+
+        // defined in TransformComponent.h, needs the complete component type
+        void NotifyChanged();
+    };
+}
@@ -1,7 +1,15 @@
 #pragma once
 
 
+#include<array>
+#include<bit>
+#include<chrono>
+#include<cstdint>
+#include<cstring>
+#include<random>
+#include<span>
 #include<string>
+#include<thread>
 #include<stduuid/uuid.h>
 
 namespace GiiGa
@@ -17,6 +25,63 @@ namespace GiiGa
         {
         }
 
+        // xoshiro256**, seeded once per thread
+        struct Generator
+        {
+            std::array<uint64_t, 4> state;
+
+            static uint64_t SplitMix(uint64_t& x)
+            {
+                uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+                z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+                z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+                return z ^ (z >> 31);
+            }
+
+            static Generator Seeded()
+            {
+                // random_device may be deterministic on some platforms, mix in time and thread id
+                std::random_device rd;
+                uint64_t seed = (static_cast<uint64_t>(rd()) << 32) ^ rd();
+                seed ^= static_cast<uint64_t>(std::chrono::high_resolution_clock::now().time_since_epoch().count());
+                seed ^= static_cast<uint64_t>(std::hash<std::thread::id>()(std::this_thread::get_id())) << 1;
+
+                Generator generator;
+                for (auto& word : generator.state)
+                    word = SplitMix(seed);
+                return generator;
+            }
+
+            uint64_t Next()
+            {
+                const uint64_t result = std::rotl(state[1] * 5, 7) * 9;
+                const uint64_t t = state[1] << 17;
+                state[2] ^= state[0];
+                state[3] ^= state[1];
+                state[1] ^= state[2];
+                state[0] ^= state[3];
+                state[2] ^= t;
+                state[3] = std::rotl(state[3], 45);
+                return result;
+            }
+        };
+
+        static Generator& ThreadGenerator()
+        {
+            thread_local Generator generator = Generator::Seeded();
+            return generator;
+        }
+
+        static Uuid NewFrom(Generator& generator)
+        {
+            const uint64_t words[2] = {generator.Next(), generator.Next()};
+            std::array<uuids::uuid::value_type, UUID_SIZE> bytes;
+            std::memcpy(bytes.data(), words, UUID_SIZE);
+            bytes[6] = static_cast<uuids::uuid::value_type>((bytes[6] & 0x0F) | 0x40);
+            bytes[8] = static_cast<uuids::uuid::value_type>((bytes[8] & 0x3F) | 0x80);
+            return Uuid(uuids::uuid(bytes));
+        }
+
     public:
         Uuid() = default;
 
@@ -57,16 +122,17 @@ namespace GiiGa
             uuid_.swap(other.uuid_);
         }
 
+        // RFC 4122 version 4 uuid from a per-thread generator
         static Uuid New()
         {
-            std::random_device rd;
-            auto seed_data = std::array<int, std::mt19937::state_size>{};
-            std::generate(std::begin(seed_data), std::end(seed_data), std::ref(rd));
-            std::seed_seq seq(std::begin(seed_data), std::end(seed_data));
-            std::mt19937 generator(seq);
-            uuids::uuid_random_generator gen{generator};
+            return NewFrom(ThreadGenerator());
+        }
 
-            return Uuid(gen());
+        static void NewBatch(std::span<Uuid> uuids)
+        {
+            auto& generator = ThreadGenerator();
+            for (auto& uuid : uuids)
+                uuid = NewFrom(generator);
         }
 
         static Uuid Null()
@@ -101,9 +167,26 @@ namespace GiiGa
             return std::string(uuids::to_string(uuid_));
         }
 
+        // raw 128 bits, for hashing and comparison without going through stduuid
+        std::array<uint64_t, 2> Words() const
+        {
+            std::array<uint64_t, 2> words;
+            std::memcpy(words.data(), uuid_.as_bytes().data(), UUID_SIZE);
+            return words;
+        }
+
+        // splitmix64 finalizer over both words
+        static size_t HashWords(const std::array<uint64_t, 2>& words)
+        {
+            uint64_t h = words[0] ^ (words[1] * 0x9E3779B97F4A7C15ull);
+            h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ull;
+            h = (h ^ (h >> 27)) * 0x94D049BB133111EBull;
+            return static_cast<size_t>(h ^ (h >> 31));
+        }
+
         size_t Hash() const
         {
-            return std::hash<uuids::uuid>()(uuid_);
+            return HashWords(Words());
         }
 
         bool operator==(const Uuid& other) const
@@ -0,0 +1,173 @@
+#pragma once
+#include<algorithm>
+#include<array>
+#include<bit>
+#include<cstdint>
+#include<utility>
+#include<vector>
+
+#include<Uuid.h>
+
+namespace GiiGa
+{
+    /*
+     * Open-addressing hash map keyed by Uuid.
+     * Linear probing over power-of-two capacity, keys stored as two raw words,
+     * erase shifts following entries back so there are no tombstones.
+     * Null uuid marks an empty slot and can not be inserted.
+     * Pointers returned by Find stay valid until the next Insert or Erase.
+     */
+    template <typename Value>
+    class UuidFlatMap
+    {
+    public:
+        static constexpr float MaxLoadFactor = 0.75f;
+
+        size_t Size() const { return size_; }
+        bool Empty() const { return size_ == 0; }
+
+        void Reserve(size_t count)
+        {
+            size_t capacity = std::bit_ceil(std::max<size_t>(16, static_cast<size_t>(count / MaxLoadFactor) + 1));
+            if (capacity > keys_.size())
+                Rehash(capacity);
+        }
+
+        // returns false when key is null or already present
+        bool Insert(const Uuid& uuid, Value value)
+        {
+            const Key key = uuid.Words();
+            if (IsEmptyKey(key)) return false;
+
+            if (keys_.empty() || size_ + 1 > static_cast<size_t>(keys_.size() * MaxLoadFactor))
+                Rehash(keys_.empty() ? 16 : keys_.size() * 2);
+
+            size_t slot = HashKey(key) & mask_;
+            while (!IsEmptyKey(keys_[slot]))
+            {
+                if (keys_[slot] == key) return false;
+                slot = (slot + 1) & mask_;
+            }
+
+            keys_[slot] = key;
+            values_[slot] = std::move(value);
+            ++size_;
+            return true;
+        }
+
+        Value* Find(const Uuid& uuid)
+        {
+            const size_t slot = FindSlot(uuid.Words());
+            return slot == NotFound ? nullptr : &values_[slot];
+        }
+
+        const Value* Find(const Uuid& uuid) const
+        {
+            const size_t slot = FindSlot(uuid.Words());
+            return slot == NotFound ? nullptr : &values_[slot];
+        }
+
+        bool Contains(const Uuid& uuid) const
+        {
+            return FindSlot(uuid.Words()) != NotFound;
+        }
+
+        bool Erase(const Uuid& uuid)
+        {
+            size_t hole = FindSlot(uuid.Words());
+            if (hole == NotFound) return false;
+
+            // backward shift: move every following entry whose home is not between hole and its slot
+            size_t slot = (hole + 1) & mask_;
+            while (!IsEmptyKey(keys_[slot]))
+            {
+                const size_t home = HashKey(keys_[slot]) & mask_;
+                if (((slot - home) & mask_) >= ((slot - hole) & mask_))
+                {
+                    keys_[hole] = keys_[slot];
+                    values_[hole] = std::move(values_[slot]);
+                    hole = slot;
+                }
+                slot = (slot + 1) & mask_;
+            }
+
+            keys_[hole] = Key{};
+            values_[hole] = Value{};
+            --size_;
+            return true;
+        }
+
+        void Clear()
+        {
+            keys_.clear();
+            values_.clear();
+            mask_ = 0;
+            size_ = 0;
+        }
+
+        // calls fn(value) for every stored value, order is unspecified
+        template <typename Fn>
+        void ForEachValue(Fn&& fn) const
+        {
+            for (size_t i = 0; i < keys_.size(); ++i)
+            {
+                if (!IsEmptyKey(keys_[i]))
+                    fn(values_[i]);
+            }
+        }
+
+    private:
+        using Key = std::array<uint64_t, 2>;
+        static constexpr size_t NotFound = SIZE_MAX;
+
+        std::vector<Key> keys_;
+        std::vector<Value> values_;
+        size_t mask_ = 0;
+        size_t size_ = 0;
+
+        static bool IsEmptyKey(const Key& key)
+        {
+            return (key[0] | key[1]) == 0;
+        }
+
+        static size_t HashKey(const Key& key)
+        {
+            return Uuid::HashWords(key);
+        }
+
+        size_t FindSlot(const Key& key) const
+        {
+            if (keys_.empty() || IsEmptyKey(key)) return NotFound;
+
+            size_t slot = HashKey(key) & mask_;
+            while (!IsEmptyKey(keys_[slot]))
+            {
+                if (keys_[slot] == key) return slot;
+                slot = (slot + 1) & mask_;
+            }
+            return NotFound;
+        }
+
+        void Rehash(size_t capacity)
+        {
+            std::vector<Key> old_keys = std::move(keys_);
+            std::vector<Value> old_values = std::move(values_);
+
+            keys_.assign(capacity, Key{});
+            values_.clear();
+            values_.resize(capacity);
+            mask_ = capacity - 1;
+
+            for (size_t i = 0; i < old_keys.size(); ++i)
+            {
+                if (IsEmptyKey(old_keys[i])) continue;
+
+                size_t slot = HashKey(old_keys[i]) & mask_;
+                while (!IsEmptyKey(keys_[slot]))
+                    slot = (slot + 1) & mask_;
+                keys_[slot] = old_keys[i];
+                values_[slot] = std::move(old_values[i]);
+            }
+        }
+    };
+}
@@ -0,0 +1,150 @@
+#pragma once
+#include<algorithm>
+#include<atomic>
+#include<condition_variable>
+#include<cstdint>
+#include<functional>
+#include<memory>
+#include<mutex>
+#include<thread>
+#include<vector>
+
+namespace GiiGa
+{
+    struct WorkerPoolSettings
+    {
+        // 0 picks hardware_concurrency - 1, read once on first use
+        static inline uint32_t WorkerCount = 0;
+    };
+
+    /*
+     * Persistent worker threads for data-parallel loops.
+     * ParallelFor splits a range into chunks, the calling thread takes chunks too and returns when all are done.
+     * One loop runs at a time, calls from inside a running loop execute inline.
+     */
+    class WorkerPool
+    {
+    public:
+        static WorkerPool& GetInstance()
+        {
+            if (!instance_) instance_ = std::make_unique<WorkerPool>();
+            return *instance_;
+        }
+
+        WorkerPool()
+        {
+            uint32_t count = WorkerPoolSettings::WorkerCount;
+            if (count == 0) count = std::max(1u, std::thread::hardware_concurrency()) - 1;
+
+            workers_.reserve(count);
+            for (uint32_t i = 0; i < count; ++i)
+                workers_.emplace_back([this] { WorkerLoop(); });
+        }
+
+        ~WorkerPool()
+        {
+            {
+                std::lock_guard lock(mutex_);
+                quit_ = true;
+            }
+            wake_.notify_all();
+            for (auto& worker : workers_)
+                worker.join();
+        }
+
+        WorkerPool(const WorkerPool&) = delete;
+        WorkerPool& operator=(const WorkerPool&) = delete;
+
+        size_t WorkerCount() const { return workers_.size(); }
+
+        // fn(begin, end) is called for disjoint sub-ranges covering [0, count), each at least min_chunk long except the last
+        void ParallelFor(size_t count, size_t min_chunk, const std::function<void(size_t, size_t)>& fn)
+        {
+            if (count == 0) return;
+
+            min_chunk = std::max<size_t>(min_chunk, 1);
+            const size_t max_chunks = (count + min_chunk - 1) / min_chunk;
+            const size_t chunks = std::min(max_chunks, (workers_.size() + 1) * 4);
+            if (chunks <= 1 || workers_.empty() || inside_loop_)
+            {
+                fn(0, count);
+                return;
+            }
+
+            std::lock_guard loop_lock(loop_mutex_);
+            {
+                std::lock_guard lock(mutex_);
+                job_ = &fn;
+                count_ = count;
+                chunk_size_ = (count + chunks - 1) / chunks;
+                chunk_count_ = (count + chunk_size_ - 1) / chunk_size_;
+                next_chunk_.store(0, std::memory_order_relaxed);
+                done_chunks_.store(0, std::memory_order_relaxed);
+                ++generation_;
+            }
+            wake_.notify_all();
+
+            RunChunks();
+
+            std::unique_lock lock(mutex_);
+            done_.wait(lock, [this] { return done_chunks_.load(std::memory_order_acquire) == chunk_count_ && busy_workers_ == 0; });
+            job_ = nullptr;
+        }
+
+    private:
+        static inline std::unique_ptr<WorkerPool> instance_ = nullptr;
+        static inline thread_local bool inside_loop_ = false;
+
+        std::vector<std::thread> workers_;
+        std::mutex loop_mutex_;
+        std::mutex mutex_;
+        std::condition_variable wake_;
+        std::condition_variable done_;
+        bool quit_ = false;
+        uint64_t generation_ = 0;
+        uint32_t busy_workers_ = 0;
+
+        const std::function<void(size_t, size_t)>* job_ = nullptr;
+        size_t count_ = 0;
+        size_t chunk_size_ = 0;
+        size_t chunk_count_ = 0;
+        std::atomic<size_t> next_chunk_ = 0;
+        std::atomic<size_t> done_chunks_ = 0;
+
+        void RunChunks()
+        {
+            inside_loop_ = true;
+            for (size_t chunk = next_chunk_.fetch_add(1, std::memory_order_relaxed); chunk < chunk_count_;
+                 chunk = next_chunk_.fetch_add(1, std::memory_order_relaxed))
+            {
+                const size_t begin = chunk * chunk_size_;
+                (*job_)(begin, std::min(begin + chunk_size_, count_));
+                done_chunks_.fetch_add(1, std::memory_order_release);
+            }
+            inside_loop_ = false;
+        }
+
+        void WorkerLoop()
+        {
+            uint64_t seen_generation = 0;
+            while (true)
+            {
+                {
+                    std::unique_lock lock(mutex_);
+                    wake_.wait(lock, [&] { return quit_ || (generation_ != seen_generation && job_); });
+                    if (quit_) return;
+                    seen_generation = generation_;
+                    ++busy_workers_;
+                }
+
+                RunChunks();
+
+                {
+                    std::lock_guard lock(mutex_);
+                    --busy_workers_;
+                }
+                done_.notify_all();
+            }
+        }
+    };
+}
@@ -4,6 +4,9 @@
 #include <pybind11/conduit/wrap_include_python_h.h>
 
 
+#include<chrono>
+#include<limits>
+#include<optional>
 #include<vector>
 #include<memory>
 #include<json/json.h>
@@ -44,49 +47,82 @@ namespace GiiGa
 
         static void DeInitialize()
         {
+            DetachDestroyed();
+            ReleaseDestroyed(0.0);
             GetInstance().levels_.clear();
             instance_.reset();
         }
 
         static void Tick(float dt)
+        {
+            RunInitQueues();
+            TickGroup(TickType::PrePhysics, dt);
+        }
+
+        // Init and then BeginPlay of queued components within InitQueueSettings::BudgetMs, rest waits for next frame.
+        // BeginPlay waits until every queued Init ran, queued components tick from the frame their BeginPlay ran.
+        static void RunInitQueues()
         {
             auto& instance = GetInstance();
-            while (!instance.comp_init_queue_.empty())
+            const double budget_ms = InitQueueSettings::BudgetMs;
+            const auto start = std::chrono::steady_clock::now();
+            size_t ran = 0;
+            auto out_of_budget = [&]()
             {
-                auto comp_to_init = instance.comp_init_queue_.front();
-                instance.comp_init_queue_.pop();
-                if (!comp_to_init.expired())
+                return budget_ms > 0 && ran > 0 && std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() >= budget_ms;
+            };
+
+            // order only matters when queues are spread over frames
+            if (budget_ms > 0)
+            {
+                if (const auto focus = FindInitFocus())
                 {
-                    comp_to_init.lock()->Init();
-                    if (instance.state_ == WorldState::Play)
-                        AddComponentToBeginPlayQueue(comp_to_init.lock());
+                    auto distance = [&focus](const std::weak_ptr<IComponent>& component)
+                    {
+                        return DistanceSquaredToOwner(component, *focus);
+                    };
+                    instance.comp_init_queue_.SortNearCamera(distance);
+                    instance.comp_begin_play_queue_.SortNearCamera(distance);
                 }
             }
 
-            while (!instance.comp_begin_play_queue_.empty())
+            while (!instance.comp_init_queue_.Empty() && !out_of_budget())
             {
-                auto comp_to_bp = instance.comp_begin_play_queue_.front();
-                instance.comp_begin_play_queue_.pop();
-                if (!comp_to_bp.expired())
+                auto comp_to_init = instance.comp_init_queue_.Pop().lock();
+                ++instance.init_progress_.done;
+                if (comp_to_init)
                 {
-                    comp_to_bp.lock()->BeginPlay();
+                    comp_to_init->Init();
+                    comp_to_init->initialized = true;
+                    if (instance.state_ == WorldState::Play)
+                        AddComponentToBeginPlayQueue(comp_to_init);
+                    ++ran;
                 }
             }
 
-
-            for (auto& level : GetLevels())
+            while (instance.comp_init_queue_.Empty() && !instance.comp_begin_play_queue_.Empty() && !out_of_budget())
             {
-                if (!level->GetIsActive())
-                {
-                    continue;
-                }
-                const auto& level_root_gos = level->GetRootGameObjects();
-                for (int i = 0; i < level_root_gos.size(); ++i)
+                auto comp_to_bp = instance.comp_begin_play_queue_.Pop().lock();
+                ++instance.init_progress_.done;
+                if (comp_to_bp)
                 {
-                    if (level_root_gos[i]->tick_type == TickType::Default)
-                        level_root_gos[i]->Tick(dt);
+                    comp_to_bp->begin_play_pending = false;
+                    comp_to_bp->BeginPlay();
+                    ++ran;
                 }
             }
+
+            if (instance.comp_init_queue_.Empty() && instance.comp_begin_play_queue_.Empty())
+                instance.init_progress_ = {};
+        }
+
+        // end of frame: objects destroyed during the frame leave world together, physics bodies go in one batch
+        static void FlushDestroyed()
+        {
+            PhysicsSystem::BeginBodyRemovalBatch();
+            DetachDestroyed();
+            ReleaseDestroyed(DestroySettings::ReleaseBudgetMs);
+            PhysicsSystem::EndBodyRemovalBatch();
         }
 
         static const std::vector<std::shared_ptr<Level>>& GetLevels()
@@ -136,6 +172,35 @@ namespace GiiGa
         }
 
     private:
+        // location of first camera in active game object, NearCamera components initialize closest to it first
+        static std::optional<Vector3> FindInitFocus()
+        {
+            std::optional<Vector3> focus;
+            ForEachComponentOfType<CameraComponent>([&focus](const std::shared_ptr<CameraComponent>& camera)
+            {
+                if (focus) return;
+                auto owner = std::dynamic_pointer_cast<GameObject>(camera->GetOwner());
+                if (!owner || !owner->IsActive()) return;
+                if (auto transform = owner->GetTransformComponent().lock())
+                    focus = transform->GetWorldLocation();
+            });
+            return focus;
+        }
+
+        static float DistanceSquaredToOwner(const std::weak_ptr<IComponent>& component, const Vector3& focus)
+        {
+            auto l_component = std::dynamic_pointer_cast<Component>(component.lock());
+            if (!l_component) return std::numeric_limits<float>::max();
+
+            auto owner = std::dynamic_pointer_cast<GameObject>(l_component->GetOwner());
+            if (!owner) return std::numeric_limits<float>::max();
+
+            auto transform = owner->GetTransformComponent().lock();
+            if (!transform) return std::numeric_limits<float>::max();
+
+            return Vector3::DistanceSquared(transform->GetWorldLocation(), focus);
+        }
+
         std::vector<std::shared_ptr<Level>> levels_;
 
         WorldState state_;
@@ -166,6 +231,7 @@ namespace GiiGa
             if (levels_.size() >= 2)
             {
                 GiiGa::PhysicsSystem::EndPlay();
+                ClearBeginPlayQueue();
                 for (auto&& level : levels_)
                 {
                     level->EndPlay();